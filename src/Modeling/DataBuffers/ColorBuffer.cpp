@@ -24,6 +24,7 @@
 \******************************************************************************/
 
 #include "ColorBuffer.hpp"
+#include "Modeling/GLStateCache.hpp"
 #include <algorithm>
 
 
@@ -55,17 +56,29 @@ void ColorBuffer::store(GLuint programHandle)
     glGenBuffers(1, &colorBuffer_);
     colorAttrib_ = glGetAttribLocation(programHandle, "vertexColor");
 
-    glBindBuffer(GL_ARRAY_BUFFER, colorBuffer_);
+    GLStateCache::getInstance().bindBuffer(GL_ARRAY_BUFFER, colorBuffer_);
     glBufferData(GL_ARRAY_BUFFER, colors_.size() * sizeof(glm::vec3),
         colors_.data(), GL_STATIC_DRAW);
 }
 
 
 
+// Replace the colors, must be called from the rendering thread
+void ColorBuffer::update(const std::vector<glm::vec3>& colors)
+{
+    colors_ = colors;
+
+    GLStateCache::getInstance().bindBuffer(GL_ARRAY_BUFFER, colorBuffer_);
+    glBufferData(GL_ARRAY_BUFFER, colors_.size() * sizeof(glm::vec3),
+        colors_.data(), GL_DYNAMIC_DRAW);
+}
+
+
+
 void ColorBuffer::enable()
 {
-    glEnableVertexAttribArray(colorAttrib_);
-    glBindBuffer(GL_ARRAY_BUFFER, colorBuffer_);
+    GLStateCache::getInstance().enableVertexAttribArray(colorAttrib_);
+    GLStateCache::getInstance().bindBuffer(GL_ARRAY_BUFFER, colorBuffer_);
     glVertexAttribPointer(colorAttrib_, 3, GL_FLOAT, GL_FALSE, 0, 0);
 }
 
@@ -73,7 +86,14 @@ void ColorBuffer::enable()
 
 void ColorBuffer::disable()
 {
-    glDisableVertexAttribArray(colorAttrib_);
+    GLStateCache::getInstance().disableVertexAttribArray(colorAttrib_);
+}
+
+
+
+bool ColorBuffer::belongsInVertexArray()
+{
+    return true;
 }
 
 
@@ -46,8 +46,10 @@ class ColorBuffer : public OptionalDataBuffer
         std::vector<glm::vec3> getColors();
 
         virtual void store(GLuint programHandle);
+        void update(const std::vector<glm::vec3>& colors);
         virtual void enable();
         virtual void disable();
+        virtual bool belongsInVertexArray();
 
         virtual SnippetPtr getVertexShaderGLSL();
         virtual SnippetPtr getFragmentShaderGLSL();
@@ -0,0 +1,195 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+#include "CylinderImpostor.hpp"
+#include "glm/gtc/type_ptr.hpp"
+
+
+CylinderImpostor::CylinderImpostor(const glm::vec3& color) :
+    color_(color)
+{}
+
+
+
+void CylinderImpostor::store(GLuint programHandle)
+{
+    colorUniform_ = glGetUniformLocation(programHandle, "impostorColor");
+}
+
+
+
+void CylinderImpostor::enable()
+{
+    glUniform3fv(colorUniform_, 1, glm::value_ptr(color_));
+}
+
+
+
+void CylinderImpostor::disable()
+{}
+
+
+
+bool CylinderImpostor::belongsInVertexArray()
+{
+    return false;
+}
+
+
+
+SnippetPtr CylinderImpostor::getVertexShaderGLSL()
+{
+    return std::make_shared<ShaderSnippet>(
+        R".(
+            //CylinderImpostor fields
+            varying vec3 impostorPoint, impostorStart, impostorEnd; //view space
+            varying float impostorRadius;
+        ).",
+        R".(
+            //CylinderImpostor methods
+            //how far a sphere at point can reach on the plane, as seen
+            //from the camera; the last factor allows for oblique rays
+            float reachOnPlane(vec3 point, vec3 f, float planeDepth, float radius)
+            {
+                float depth = max(dot(point, f), 1e-4);
+                float distance = length(point);
+                float grazing = sqrt(max(distance * distance - radius * radius,
+                                         1e-6));
+                return radius * (planeDepth / depth) * (distance / grazing) *
+                    (distance / depth);
+            }
+
+            //a rectangle facing the camera through the cylinder's middle,
+            //covering both of the spheres that bound its ends
+            vec3 coverCylinder(vec3 start, vec3 end, float radius, vec2 corner)
+            {
+                vec3 middle = 0.5 * (start + end);
+                vec3 f = normalize(middle);
+                float planeDepth = dot(middle, f);
+
+                vec3 startOnPlane = start * (planeDepth / max(dot(start, f), 1e-4));
+                vec3 endOnPlane = end * (planeDepth / max(dot(end, f), 1e-4));
+                vec3 along = endOnPlane - startOnPlane;
+                float span = length(along);
+
+                //seen end-on, any direction across the plane will do
+                vec3 up = abs(f.y) > 0.99 ? vec3(1, 0, 0) : vec3(0, 1, 0);
+                vec3 u = span > 0.01 * radius ? along / span :
+                                                normalize(cross(up, f));
+                vec3 v = cross(u, f);
+
+                float startReach = reachOnPlane(start, f, planeDepth, radius);
+                float endReach = reachOnPlane(end, f, planeDepth, radius);
+                float low = min(-startReach, span - endReach);
+                float high = max(startReach, span + endReach);
+                float side = max(startReach, endReach);
+
+                float x = mix(low, high, 0.5 * corner.x + 0.5);
+                return startOnPlane + u * x + v * (corner.y * side);
+            }
+        ).",
+        R".(
+            //CylinderImpostor main method code
+            mat4 modelView = viewMatrix * modelMatrix;
+            impostorStart = (modelView * vec4(0, 0, 0, 1)).xyz;
+            impostorEnd = (modelView * vec4(0, 0, 1, 1)).xyz;
+            impostorRadius = 0.5 * length(modelMatrix[0].xyz);
+            impostorPoint = coverCylinder(impostorStart, impostorEnd,
+                                          impostorRadius, vertex.xy);
+            gl_Position = projMatrix * vec4(impostorPoint, 1);
+        )."
+    );
+}
+
+
+
+SnippetPtr CylinderImpostor::getFragmentShaderGLSL()
+{
+    return std::make_shared<ShaderSnippet>(
+        R".(
+            //CylinderImpostor fields
+            varying vec3 impostorPoint, impostorStart, impostorEnd; //view space
+            varying float impostorRadius;
+            uniform vec3 impostorColor;
+        ).",
+        R".(
+            //CylinderImpostor methods
+            //Inigo Quilez's ray and capped cylinder intersection, returning
+            //the distance to the hit and its normal, or -1 for a miss
+            vec4 castCylinder(vec3 origin, vec3 ray, vec3 start, vec3 end,
+                              float radius)
+            {
+                vec3 ba = end - start;
+                vec3 oc = origin - start;
+                float baba = dot(ba, ba);
+                float bard = dot(ba, ray);
+                float baoc = dot(ba, oc);
+                float k2 = baba - bard * bard;
+                float k1 = baba * dot(oc, ray) - baoc * bard;
+                float k0 = baba * dot(oc, oc) - baoc * baoc -
+                           radius * radius * baba;
+
+                float h = k1 * k1 - k2 * k0;
+                if (h < 0.0)
+                    return vec4(-1.0);
+                h = sqrt(h);
+
+                float t = (-k1 - h) / k2;
+                float y = baoc + t * bard;
+                if (y > 0.0 && y < baba) //the side
+                    return vec4(t, (oc + t * ray - ba * y / baba) / radius);
+
+                t = ((y < 0.0 ? 0.0 : baba) - baoc) / bard;
+                if (abs(k1 + k2 * t) < h) //one of the caps
+                    return vec4(t, ba * sign(y) / sqrt(baba));
+                return vec4(-1.0);
+            }
+        ).",
+        R".(
+            //CylinderImpostor main method code
+            vec3 ray = normalize(impostorPoint); //the camera is at the origin
+
+            //start the ray just short of the bond, since far away the
+            //quadratic's terms would cancel out in single precision
+            vec3 bondMiddle = 0.5 * (impostorStart + impostorEnd);
+            float bondReach = 0.5 * length(impostorEnd - impostorStart) +
+                              impostorRadius;
+            float skipped = max(dot(bondMiddle, ray) - bondReach, 0.0);
+
+            vec4 intersection = castCylinder(ray * skipped, ray,
+                impostorStart, impostorEnd, impostorRadius);
+            if (intersection.x < 0.0)
+                discard; //the ray misses the cylinder
+
+            vec3 hit = ray * (skipped + intersection.x);
+            vec4 clipHit = projMatrix * vec4(hit, 1);
+            gl_FragDepth = 0.5 * clipHit.z / clipHit.w + 0.5;
+
+            //a little shading, so that the bond looks round
+            float facing = max(dot(intersection.yzw, -ray), 0.0);
+            colors.material = impostorColor * (0.6 + 0.4 * facing);
+        )."
+    );
+}
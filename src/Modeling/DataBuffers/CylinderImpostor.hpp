@@ -0,0 +1,63 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+#ifndef CYLINDER_IMPOSTOR
+#define CYLINDER_IMPOSTOR
+
+/**
+    A CylinderImpostor draws each instance of a Model as a smooth, capped
+    cylinder, the way that a SphereImpostor draws spheres, and it expects the
+    same square Mesh. The model matrix is read as a bond matrix: its z axis
+    runs from the start of the cylinder to its end, and its x axis spans the
+    cylinder's diameter. The vertex shader stretches the square over the
+    cylinder's outline as seen from the camera, and the fragment shader
+    intersects each pixel's ray with the cylinder and its caps, discarding
+    misses and writing the depth of each hit, so bonds meet atom impostors
+    exactly where their surfaces cross.
+**/
+
+#include "OptionalDataBuffer.hpp"
+#include <glm/glm.hpp>
+#include <memory>
+
+class CylinderImpostor : public OptionalDataBuffer
+{
+    public:
+        CylinderImpostor(const glm::vec3& color);
+
+        virtual void store(GLuint programHandle);
+        virtual void enable();
+        virtual void disable();
+        virtual bool belongsInVertexArray();
+
+        virtual SnippetPtr getVertexShaderGLSL();
+        virtual SnippetPtr getFragmentShaderGLSL();
+
+    private:
+        glm::vec3 color_;
+        GLint colorUniform_;
+};
+
+#endif
@@ -24,6 +24,7 @@
 \******************************************************************************/
 
 #include "IndexBuffer.hpp"
+#include "Modeling/GLStateCache.hpp"
 #include <algorithm>
 #include <stdexcept>
 
@@ -48,13 +49,27 @@ void IndexBuffer::store(GLuint)
 {
     glGenBuffers(1, &indexBuffer_);
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer_);
+    GLStateCache::getInstance().bindBuffer(GL_ELEMENT_ARRAY_BUFFER,
+        indexBuffer_);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices_.size() * sizeof(GLuint),
         indices_.data(), GL_STATIC_DRAW);
 }
 
 
 
+// Replace the indices, must be called from the rendering thread
+void IndexBuffer::update(const std::vector<GLuint>& indices)
+{
+    indices_ = indices;
+
+    GLStateCache::getInstance().bindBuffer(GL_ELEMENT_ARRAY_BUFFER,
+        indexBuffer_);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices_.size() * sizeof(GLuint),
+        indices_.data(), GL_DYNAMIC_DRAW);
+}
+
+
+
 void IndexBuffer::draw(GLenum mode)
 {
     glDrawElements(mode, (int)indices_.size(), GL_UNSIGNED_INT, 0);
@@ -62,6 +77,14 @@ void IndexBuffer::draw(GLenum mode)
 
 
 
+void IndexBuffer::drawInstanced(GLenum mode, GLsizei instances)
+{
+    glDrawElementsInstancedARB(mode, (int)indices_.size(), GL_UNSIGNED_INT, 0,
+                               instances);
+}
+
+
+
 bool IndexBuffer::canInterpretAs(GLenum type)
 {
     return (type == GL_TRIANGLES && indices_.size() % 3 == 0) ||
@@ -134,9 +157,17 @@ std::vector<Triangle> IndexBuffer::castToTriangles()
 
 
 
+std::size_t IndexBuffer::getIndexCount()
+{
+    return indices_.size();
+}
+
+
+
 void IndexBuffer::enable()
 {
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer_);
+    GLStateCache::getInstance().bindBuffer(GL_ELEMENT_ARRAY_BUFFER,
+        indexBuffer_);
 }
 
 
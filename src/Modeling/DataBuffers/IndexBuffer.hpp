@@ -46,12 +46,15 @@ class IndexBuffer : public DataBuffer
         IndexBuffer(const std::vector<GLuint>& indices, GLenum type = GL_TRIANGLES);
 
         void draw(GLenum mode);
+        void drawInstanced(GLenum mode, GLsizei instances);
         bool canInterpretAs(GLenum type);
         std::vector<Triangle> reinterpretAsTriangles();
         std::vector<Quad> reinterpretAsQuads();
         std::vector<Triangle> castToTriangles();
+        std::size_t getIndexCount();
 
         virtual void store(GLuint programHandle);
+        void update(const std::vector<GLuint>& indices);
         virtual void enable();
         virtual void disable();
 
@@ -0,0 +1,127 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+#include "NormalBuffer.hpp"
+#include "Modeling/GLStateCache.hpp"
+
+
+NormalBuffer::NormalBuffer(const std::vector<glm::vec3>& normals) :
+    normals_(normals)
+{}
+
+
+
+std::vector<glm::vec3> NormalBuffer::getNormals()
+{
+    return normals_;
+}
+
+
+
+// Store the normals in a GPU buffer
+void NormalBuffer::store(GLuint programHandle)
+{
+    glGenBuffers(1, &normalBuffer_);
+    normalAttrib_ = glGetAttribLocation(programHandle, "vertexNormal");
+
+    GLStateCache::getInstance().bindBuffer(GL_ARRAY_BUFFER, normalBuffer_);
+    glBufferData(GL_ARRAY_BUFFER, normals_.size() * sizeof(glm::vec3),
+        normals_.data(), GL_STATIC_DRAW);
+}
+
+
+
+// Replace the normals, must be called from the rendering thread
+void NormalBuffer::update(const std::vector<glm::vec3>& normals)
+{
+    normals_ = normals;
+
+    GLStateCache::getInstance().bindBuffer(GL_ARRAY_BUFFER, normalBuffer_);
+    glBufferData(GL_ARRAY_BUFFER, normals_.size() * sizeof(glm::vec3),
+        normals_.data(), GL_DYNAMIC_DRAW);
+}
+
+
+
+void NormalBuffer::enable()
+{
+    GLStateCache::getInstance().enableVertexAttribArray(normalAttrib_);
+    GLStateCache::getInstance().bindBuffer(GL_ARRAY_BUFFER, normalBuffer_);
+    glVertexAttribPointer(normalAttrib_, 3, GL_FLOAT, GL_FALSE, 0, 0);
+}
+
+
+
+void NormalBuffer::disable()
+{
+    GLStateCache::getInstance().disableVertexAttribArray(normalAttrib_);
+}
+
+
+
+bool NormalBuffer::belongsInVertexArray()
+{
+    return true;
+}
+
+
+
+SnippetPtr NormalBuffer::getVertexShaderGLSL()
+{
+    return std::make_shared<ShaderSnippet>(
+        R".(
+            //NormalBuffer fields
+            attribute vec3 vertexNormal;
+            varying vec3 viewNormal;
+        ).",
+        R".(
+            //NormalBuffer methods
+        ).",
+        R".(
+            //NormalBuffer main method code
+            viewNormal = mat3(viewMatrix * modelMatrix) * vertexNormal;
+        )."
+    );
+}
+
+
+
+SnippetPtr NormalBuffer::getFragmentShaderGLSL()
+{
+    return std::make_shared<ShaderSnippet>(
+        R".(
+            //NormalBuffer fields
+            varying vec3 viewNormal;
+        ).",
+        R".(
+            //NormalBuffer methods
+        ).",
+        R".(
+            //NormalBuffer main method code
+            float facing = abs(normalize(viewNormal).z);
+            colors.lightBlend = vec3(0.3 + 0.7 * facing);
+        )."
+    );
+}
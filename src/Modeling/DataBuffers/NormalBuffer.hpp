@@ -0,0 +1,65 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+#ifndef NORMAL_BUFFER
+#define NORMAL_BUFFER
+
+/**
+    A NormalBuffer assigns a surface normal to each vertex in a Mesh. Since the
+    Scene has no lights by default, the normals are used for simple headlight
+    shading: faces pointing towards the Camera are fully lit, and faces seen
+    edge-on fade towards a dim minimum. This gives curved surfaces such as the
+    molecular surface their shape without needing a Light.
+**/
+
+#include "OptionalDataBuffer.hpp"
+#include <glm/glm.hpp>
+#include <vector>
+#include <memory>
+
+class NormalBuffer : public OptionalDataBuffer
+{
+    public:
+        NormalBuffer(const std::vector<glm::vec3>& normals);
+        std::vector<glm::vec3> getNormals();
+
+        virtual void store(GLuint programHandle);
+        void update(const std::vector<glm::vec3>& normals);
+        virtual void enable();
+        virtual void disable();
+        virtual bool belongsInVertexArray();
+
+        virtual SnippetPtr getVertexShaderGLSL();
+        virtual SnippetPtr getFragmentShaderGLSL();
+
+    private:
+        std::vector<glm::vec3> normals_;
+        GLuint normalBuffer_;
+        GLint normalAttrib_;
+};
+
+typedef std::shared_ptr<NormalBuffer> NormalPtr;
+
+#endif
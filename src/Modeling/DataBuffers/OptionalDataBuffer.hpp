@@ -27,14 +27,19 @@
 #define OPTIONAL_DATA_BUFFER
 
 /**
-	An OptionalDataBuffer is simply categorical, and has no definitions.
-	It is used to distinguish optional Model information from optional
-	or non-essential data that adds specialized properties to the Model.
+	An OptionalDataBuffer is mostly categorical. It is used to distinguish
+	optional Model information from optional or non-essential data that
+	adds specialized properties to the Model. Buffers whose enable() only
+	sets vertex attributes belong in the Model's vertex array object, and are
+	enabled once; the others set uniforms or textures, and are enabled per draw.
 **/
 
 #include "DataBuffer.hpp"
 
 class OptionalDataBuffer : public DataBuffer
-{};
+{
+    public:
+        virtual bool belongsInVertexArray() = 0;
+};
 
 #endif
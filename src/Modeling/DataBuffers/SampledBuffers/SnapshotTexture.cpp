@@ -0,0 +1,157 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+#include "SnapshotTexture.hpp"
+#include "Modeling/Shading/Program.hpp"
+#include <stdexcept>
+#include <iostream>
+
+
+SnapshotTexture::SnapshotTexture(std::size_t nAtoms,
+                                 const std::vector<glm::vec3>& positions) :
+    nAtoms_(nAtoms), texels_(positions), uploaded_(false)
+{
+    if (nAtoms_ == 0 || positions.size() % nAtoms_ != 0)
+        throw std::runtime_error("Expected the same atoms in every snapshot!");
+
+    textureHeight_ = (GLsizei)((texels_.size() + TEXTURE_WIDTH - 1) / TEXTURE_WIDTH);
+    texels_.resize((std::size_t)(textureHeight_ * TEXTURE_WIDTH));
+    interpolation_ = { 0, 0, 0 };
+}
+
+
+
+//vertex texture fetch of float textures is not universal on GL 2.1 hardware
+bool SnapshotTexture::isSupported(std::size_t nTexels)
+{
+    if (!GLEW_ARB_texture_float)
+        return false;
+
+    GLint vertexTextureUnits = 0, maxTextureSize = 0;
+    glGetIntegerv(GL_MAX_VERTEX_TEXTURE_IMAGE_UNITS, &vertexTextureUnits);
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+
+    auto rows = (nTexels + TEXTURE_WIDTH - 1) / TEXTURE_WIDTH;
+    return vertexTextureUnits > 0 && maxTextureSize >= TEXTURE_WIDTH &&
+        rows <= (std::size_t)maxTextureSize;
+}
+
+
+
+//may be called from any thread, takes effect at the next render
+void SnapshotTexture::setInterpolation(int snapshotA, int snapshotB, float blend)
+{
+    std::lock_guard<std::mutex> lock(interpolationMutex_);
+    interpolation_ = { snapshotA, snapshotB, blend };
+}
+
+
+
+SnapshotTexture::Interpolation SnapshotTexture::getInterpolation()
+{
+    std::lock_guard<std::mutex> lock(interpolationMutex_);
+    return interpolation_;
+}
+
+
+
+//uploads the texture if needed, and sets the Program's constant uniforms
+void SnapshotTexture::store(GLuint programHandle)
+{
+    if (!uploaded_)
+        upload();
+
+    //the Program is in use while its Models are being stored
+    glUniform1i(glGetUniformLocation(programHandle, "snapshotPositions"), 0);
+    glUniform1f(glGetUniformLocation(programHandle, "atomCount"), (float)nAtoms_);
+    glUniform2f(glGetUniformLocation(programHandle, "snapshotTextureSize"),
+                (float)TEXTURE_WIDTH, (float)textureHeight_);
+}
+
+
+
+void SnapshotTexture::upload()
+{
+    std::cout << "Uploading " << texels_.size() << " snapshot positions... ";
+
+    glGenTextures(1, &texture_);
+    glBindTexture(GL_TEXTURE_2D, texture_);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB32F_ARB, TEXTURE_WIDTH, textureHeight_,
+                 0, GL_RGB, GL_FLOAT, texels_.data());
+
+    std::vector<glm::vec3>().swap(texels_); //the GPU has them now
+    uploaded_ = true;
+
+    std::cout << "done." << std::endl;
+    checkGlError();
+}
+
+
+
+void SnapshotTexture::bind()
+{
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, texture_);
+}
+
+
+
+std::string SnapshotTexture::getVertexShaderFields()
+{
+    return R".(
+            //SnapshotTexture fields
+            uniform sampler2D snapshotPositions;
+            uniform vec2 snapshotTextureSize; //in texels
+            uniform float atomCount;
+            uniform float snapshotA, snapshotB, snapshotBlend;
+        ).";
+}
+
+
+
+std::string SnapshotTexture::getVertexShaderMethods()
+{
+    return R".(
+            //SnapshotTexture methods
+            vec3 fetchPosition(float snapshot, float atom)
+            {
+                float texel = snapshot * atomCount + atom;
+                float row = floor((texel + 0.5) / snapshotTextureSize.x);
+                float column = texel - row * snapshotTextureSize.x;
+                vec2 coordinates = (vec2(column, row) + 0.5) / snapshotTextureSize;
+                return texture2DLod(snapshotPositions, coordinates, 0.0).xyz;
+            }
+
+            vec3 interpolatePosition(float atom)
+            {
+                return mix(fetchPosition(snapshotA, atom),
+                           fetchPosition(snapshotB, atom), snapshotBlend);
+            }
+        ).";
+}
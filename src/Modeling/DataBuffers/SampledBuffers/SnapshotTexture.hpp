@@ -0,0 +1,86 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+#ifndef SNAPSHOT_TEXTURE
+#define SNAPSHOT_TEXTURE
+
+/**
+    A SnapshotTexture uploads the position of every atom in every snapshot
+    into a floating-point texture, once, so that vertex shaders can fetch an
+    atom's position in snapshots A and B and blend between them themselves.
+    Animating then only costs setting three uniforms per frame no matter how
+    many atoms or bonds there are. The texels are laid out snapshot after
+    snapshot, wrapped into rows of TEXTURE_WIDTH. A SnapshotTexture is not a
+    DataBuffer itself: it is shared by the SnapshotPlacements of every model
+    that reads from it, and is uploaded when the first of them is stored.
+**/
+
+#include "Modeling/DataBuffers/DataBuffer.hpp"
+#include "glm/glm.hpp"
+#include <vector>
+#include <string>
+#include <memory>
+#include <mutex>
+
+class SnapshotTexture
+{
+    public:
+        static const int TEXTURE_WIDTH = 2048; //texels per row
+
+        struct Interpolation
+        {
+            int snapshotA, snapshotB;
+            float blend;
+        };
+
+    public:
+        SnapshotTexture(std::size_t nAtoms, const std::vector<glm::vec3>& positions);
+        static bool isSupported(std::size_t nTexels);
+
+        void setInterpolation(int snapshotA, int snapshotB, float blend);
+        Interpolation getInterpolation();
+
+        void store(GLuint programHandle);
+        void bind();
+        static std::string getVertexShaderFields();
+        static std::string getVertexShaderMethods();
+
+    private:
+        void upload();
+
+    private:
+        std::size_t nAtoms_;
+        std::vector<glm::vec3> texels_; //released once uploaded
+        GLsizei textureHeight_;
+        GLuint texture_;
+        bool uploaded_;
+
+        Interpolation interpolation_;
+        std::mutex interpolationMutex_;
+};
+
+typedef std::shared_ptr<SnapshotTexture> SnapshotTexturePtr;
+
+#endif
@@ -92,6 +92,14 @@ void TexturedCube::disable()
 
 
 
+//the attribute pointer follows whichever buffer is bound at the time
+bool TexturedCube::belongsInVertexArray()
+{
+    return false;
+}
+
+
+
 void TexturedCube::mapTo(GLenum target, const std::shared_ptr<Image>& img)
 {
     glTexImage2D(target, 0, GL_RGB, img->getWidth(), img->getWidth(), 0,
@@ -47,6 +47,7 @@ class TexturedCube : public OptionalDataBuffer
         virtual void store(GLuint programHandle);
         virtual void enable();
         virtual void disable();
+        virtual bool belongsInVertexArray();
 
         virtual SnippetPtr getVertexShaderGLSL();
         virtual SnippetPtr getFragmentShaderGLSL();
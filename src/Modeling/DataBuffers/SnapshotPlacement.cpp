@@ -0,0 +1,127 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+#include "SnapshotPlacement.hpp"
+
+
+SnapshotPlacement::SnapshotPlacement(const SnapshotTexturePtr& texture,
+                                     Target target) :
+    texture_(texture), target_(target)
+{}
+
+
+
+void SnapshotPlacement::store(GLuint programHandle)
+{
+    texture_->store(programHandle);
+    snapshotAUniform_ = glGetUniformLocation(programHandle, "snapshotA");
+    snapshotBUniform_ = glGetUniformLocation(programHandle, "snapshotB");
+    blendUniform_ = glGetUniformLocation(programHandle, "snapshotBlend");
+}
+
+
+
+void SnapshotPlacement::enable()
+{
+    auto interpolation = texture_->getInterpolation();
+    glUniform1f(snapshotAUniform_, (float)interpolation.snapshotA);
+    glUniform1f(snapshotBUniform_, (float)interpolation.snapshotB);
+    glUniform1f(blendUniform_, interpolation.blend);
+    texture_->bind();
+}
+
+
+
+void SnapshotPlacement::disable()
+{}
+
+
+
+bool SnapshotPlacement::belongsInVertexArray()
+{
+    return false;
+}
+
+
+
+SnippetPtr SnapshotPlacement::getVertexShaderGLSL()
+{
+    std::string fields = SnapshotTexture::getVertexShaderFields() + R".(
+            //SnapshotPlacement fields
+            attribute vec4 instanceData; //indexes of the atom(s)
+        ).";
+
+    if (target_ == Target::ATOMS)
+    {
+        return std::make_shared<ShaderSnippet>(
+            fields,
+            SnapshotTexture::getVertexShaderMethods(),
+            R".(
+                //SnapshotPlacement main method code, for atoms
+                vec3 atomCenter = interpolatePosition(instanceData.x);
+                vec4 atomVertex = modelMatrix * vec4(vertex, 1);
+                gl_Position = projMatrix * viewMatrix *
+                                vec4(atomCenter + atomVertex.xyz, 1);
+            )."
+        );
+    }
+
+    return std::make_shared<ShaderSnippet>(
+        fields,
+        SnapshotTexture::getVertexShaderMethods() + R".(
+            //SnapshotPlacement methods
+            vec3 placeAlongBond(vec3 start, vec3 end, vec3 local)
+            {
+                vec3 axis = end - start;
+                float bondLength = length(axis);
+                vec3 w = bondLength > 0.0 ? axis / bondLength : vec3(0, 0, 1);
+
+                //Duff et al. (2017), a right-handed basis with no trigonometry
+                float s = w.z >= 0.0 ? 1.0 : -1.0;
+                float a = -1.0 / (s + w.z);
+                float b = w.x * w.y * a;
+                vec3 u = vec3(1.0 + s * w.x * w.x * a, s * b, -s * w.x);
+                vec3 v = vec3(b, s + w.y * w.y * a, -w.y);
+
+                return start + u * local.x + v * local.y + w * (local.z * bondLength);
+            }
+        ).",
+        R".(
+            //SnapshotPlacement main method code, for bonds
+            vec3 bondStart = interpolatePosition(instanceData.x);
+            vec3 bondEnd = interpolatePosition(instanceData.y);
+            vec4 bondVertex = modelMatrix * vec4(vertex, 1);
+            gl_Position = projMatrix * viewMatrix *
+                vec4(placeAlongBond(bondStart, bondEnd, bondVertex.xyz), 1);
+        )."
+    );
+}
+
+
+
+SnippetPtr SnapshotPlacement::getFragmentShaderGLSL()
+{
+    return std::make_shared<ShaderSnippet>();
+}
@@ -0,0 +1,68 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+#ifndef SNAPSHOT_PLACEMENT
+#define SNAPSHOT_PLACEMENT
+
+/**
+    A SnapshotPlacement positions each instance of a Model from the atom
+    positions in a SnapshotTexture, entirely in the vertex shader. Instances
+    identify their atoms through their instance data. For atoms, x is the
+    index of the atom, and the model matrix only holds the atom's scale. For
+    bonds, x and y are the indexes of the two bonded atoms: the shader builds
+    an orthonormal basis around the bond's axis in closed form (Duff et al.,
+    "Building an Orthonormal Basis, Revisited", 2017) and stretches the mesh's
+    z axis between them, so the model matrix only holds the bond's thickness.
+**/
+
+#include "OptionalDataBuffer.hpp"
+#include "SampledBuffers/SnapshotTexture.hpp"
+
+class SnapshotPlacement : public OptionalDataBuffer
+{
+    public:
+        enum class Target : short
+        {
+            ATOMS, BONDS
+        };
+
+    public:
+        SnapshotPlacement(const SnapshotTexturePtr& texture, Target target);
+
+        virtual void store(GLuint programHandle);
+        virtual void enable();
+        virtual void disable();
+        virtual bool belongsInVertexArray();
+
+        virtual SnippetPtr getVertexShaderGLSL();
+        virtual SnippetPtr getFragmentShaderGLSL();
+
+    private:
+        SnapshotTexturePtr texture_;
+        Target target_;
+        GLint snapshotAUniform_, snapshotBUniform_, blendUniform_;
+};
+
+#endif
@@ -0,0 +1,152 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+#include "SphereImpostor.hpp"
+#include "glm/gtc/type_ptr.hpp"
+
+
+SphereImpostor::SphereImpostor(const glm::vec3& color,
+                               const glm::vec3& highlightPosition,
+                               float highlightPower,
+                               const glm::vec3& highlightColor) :
+    color_(color), highlightPosition_(highlightPosition),
+    highlightColor_(highlightColor), highlightPower_(highlightPower)
+{}
+
+
+
+void SphereImpostor::store(GLuint programHandle)
+{
+    colorUniform_ = glGetUniformLocation(programHandle, "impostorColor");
+    highlightPositionUniform_ = glGetUniformLocation(programHandle,
+                                                     "highlightPosition");
+    highlightColorUniform_ = glGetUniformLocation(programHandle,
+                                                  "highlightColor");
+    highlightPowerUniform_ = glGetUniformLocation(programHandle,
+                                                  "highlightPower");
+}
+
+
+
+void SphereImpostor::enable()
+{
+    glUniform3fv(colorUniform_, 1, glm::value_ptr(color_));
+    glUniform3fv(highlightPositionUniform_, 1,
+                 glm::value_ptr(highlightPosition_));
+    glUniform3fv(highlightColorUniform_, 1, glm::value_ptr(highlightColor_));
+    glUniform1f(highlightPowerUniform_, highlightPower_);
+}
+
+
+
+void SphereImpostor::disable()
+{}
+
+
+
+bool SphereImpostor::belongsInVertexArray()
+{
+    return false;
+}
+
+
+
+SnippetPtr SphereImpostor::getVertexShaderGLSL()
+{
+    return std::make_shared<ShaderSnippet>(
+        R".(
+            //SphereImpostor fields
+            varying vec3 impostorPoint, impostorCenter; //in view space
+            varying float impostorRadius;
+        ).",
+        R".(
+            //SphereImpostor methods
+            vec3 coverSphere(vec3 center, float radius, vec2 corner)
+            {
+                //a square facing the camera, through the sphere's center
+                float distance = length(center);
+                vec3 w = -center / distance;
+                vec3 up = abs(w.y) > 0.99 ? vec3(1, 0, 0) : vec3(0, 1, 0);
+                vec3 u = normalize(cross(up, w));
+                vec3 v = cross(w, u);
+
+                //where the cone of rays that graze the sphere meets the square
+                float grazing = distance * distance - radius * radius;
+                float halfSize = radius * distance / sqrt(max(grazing, 1e-6));
+                return center + (u * corner.x + v * corner.y) * halfSize;
+            }
+        ).",
+        R".(
+            //SphereImpostor main method code
+            impostorCenter = (viewMatrix * modelMatrix * vec4(0, 0, 0, 1)).xyz;
+            impostorRadius = length(modelMatrix[0].xyz);
+            impostorPoint = coverSphere(impostorCenter, impostorRadius, vertex.xy);
+            gl_Position = projMatrix * vec4(impostorPoint, 1);
+        )."
+    );
+}
+
+
+
+SnippetPtr SphereImpostor::getFragmentShaderGLSL()
+{
+    return std::make_shared<ShaderSnippet>(
+        R".(
+            //SphereImpostor fields
+            varying vec3 impostorPoint, impostorCenter; //in view space
+            varying float impostorRadius;
+            uniform vec3 impostorColor;
+            uniform vec3 highlightPosition, highlightColor;
+            uniform float highlightPower;
+        ).",
+        R".(
+            //SphereImpostor methods
+        ).",
+        R".(
+            //SphereImpostor main method code
+            vec3 ray = normalize(impostorPoint); //the camera is at the origin
+            float b = dot(ray, impostorCenter);
+            float c = dot(impostorCenter, impostorCenter) -
+                      impostorRadius * impostorRadius;
+            float discriminant = b * b - c;
+            if (discriminant < 0.0)
+                discard; //the ray misses the sphere
+
+            vec3 hit = ray * (b - sqrt(discriminant));
+            vec4 clipHit = projMatrix * vec4(hit, 1);
+            gl_FragDepth = 0.5 * clipHit.z / clipHit.w + 0.5;
+
+            //the highlight is in world space, like the mesh's vertices were
+            vec3 normal = (hit - impostorCenter) / impostorRadius;
+            normal = transpose(mat3(viewMatrix)) * normal;
+            vec3 luminosity = highlightColor *
+                (1.0 - length(normal - highlightPosition) / highlightPower);
+
+            colors.material = impostorColor;
+            if (all(greaterThan(luminosity, vec3(0))))
+                colors.material += luminosity;
+        )."
+    );
+}
@@ -0,0 +1,69 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+#ifndef SPHERE_IMPOSTOR
+#define SPHERE_IMPOSTOR
+
+/**
+    A SphereImpostor draws each instance of a Model as a perfect sphere, no
+    matter how coarse its Mesh. The Mesh is expected to be a square from
+    (-1, -1) to (1, 1): the vertex shader turns it to face the camera and
+    sizes it to just cover the outline of the sphere that the model matrix
+    describes, and the fragment shader casts a ray through each of its pixels.
+    Rays that miss the sphere are discarded, and those that hit it write the
+    depth of the surface they hit, so impostors intersect each other and
+    ordinary meshes correctly. The material is a single color plus the same
+    highlight that SlotViewer bakes into the vertices of its atom meshes,
+    evaluated per pixel on the sphere's normal instead.
+**/
+
+#include "OptionalDataBuffer.hpp"
+#include <glm/glm.hpp>
+#include <memory>
+
+class SphereImpostor : public OptionalDataBuffer
+{
+    public:
+        SphereImpostor(const glm::vec3& color,
+                       const glm::vec3& highlightPosition,
+                       float highlightPower,
+                       const glm::vec3& highlightColor);
+
+        virtual void store(GLuint programHandle);
+        virtual void enable();
+        virtual void disable();
+        virtual bool belongsInVertexArray();
+
+        virtual SnippetPtr getVertexShaderGLSL();
+        virtual SnippetPtr getFragmentShaderGLSL();
+
+    private:
+        glm::vec3 color_, highlightPosition_, highlightColor_;
+        float highlightPower_;
+        GLint colorUniform_, highlightPositionUniform_;
+        GLint highlightColorUniform_, highlightPowerUniform_;
+};
+
+#endif
@@ -24,6 +24,7 @@
 \******************************************************************************/
 
 #include "VertexBuffer.hpp"
+#include "Modeling/GLStateCache.hpp"
 
 
 VertexBuffer::VertexBuffer(const std::vector<glm::vec3>& vertices):
@@ -38,18 +39,30 @@ void VertexBuffer::store(GLuint programHandle)
     glGenBuffers(1, &vertexBuffer_);
     vertexAttrib_ = glGetAttribLocation(programHandle, "vertex");
 
-    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer_);
+    GLStateCache::getInstance().bindBuffer(GL_ARRAY_BUFFER, vertexBuffer_);
     glBufferData(GL_ARRAY_BUFFER, vertices_.size() * sizeof(glm::vec3),
         vertices_.data(), GL_STATIC_DRAW);
-    glEnableVertexAttribArray(vertexAttrib_);
+    GLStateCache::getInstance().enableVertexAttribArray(vertexAttrib_);
+}
+
+
+
+// Replace the vertices, must be called from the rendering thread
+void VertexBuffer::update(const std::vector<glm::vec3>& vertices)
+{
+    vertices_ = vertices;
+
+    GLStateCache::getInstance().bindBuffer(GL_ARRAY_BUFFER, vertexBuffer_);
+    glBufferData(GL_ARRAY_BUFFER, vertices_.size() * sizeof(glm::vec3),
+        vertices_.data(), GL_DYNAMIC_DRAW);
 }
 
 
 
 void VertexBuffer::enable()
 {
-    glEnableVertexAttribArray(vertexAttrib_);
-    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer_);
+    GLStateCache::getInstance().enableVertexAttribArray(vertexAttrib_);
+    GLStateCache::getInstance().bindBuffer(GL_ARRAY_BUFFER, vertexBuffer_);
     glVertexAttribPointer(vertexAttrib_, 3, GL_FLOAT, GL_FALSE, 0, 0);
 }
 
@@ -57,7 +70,7 @@ void VertexBuffer::enable()
 
 void VertexBuffer::disable()
 {
-    glDisableVertexAttribArray(vertexAttrib_);
+    GLStateCache::getInstance().disableVertexAttribArray(vertexAttrib_);
 }
 
 
@@ -69,6 +82,14 @@ void VertexBuffer::draw(GLenum mode)
 
 
 
+void VertexBuffer::drawInstanced(GLenum mode, GLsizei instances)
+{
+    glDrawElementsInstancedARB(mode, (int)vertices_.size(), GL_UNSIGNED_INT, 0,
+                               instances);
+}
+
+
+
 std::vector<glm::vec3> VertexBuffer::getVertices()
 {
     return vertices_;
@@ -76,6 +97,13 @@ std::vector<glm::vec3> VertexBuffer::getVertices()
 
 
 
+std::size_t VertexBuffer::getVertexCount()
+{
+    return vertices_.size();
+}
+
+
+
 SnippetPtr VertexBuffer::getVertexShaderGLSL()
 {
     return std::make_shared<ShaderSnippet>();
@@ -44,14 +44,17 @@ class VertexBuffer : public DataBuffer
     public:
         VertexBuffer(const std::vector<glm::vec3>& vertices);
         virtual void store(GLuint programHandle);
+        void update(const std::vector<glm::vec3>& vertices);
         virtual void enable();
         virtual void disable();
         void draw(GLenum mode);
+        void drawInstanced(GLenum mode, GLsizei instances);
 
         virtual SnippetPtr getVertexShaderGLSL();
         virtual SnippetPtr getFragmentShaderGLSL();
 
         std::vector<glm::vec3> getVertices();
+        std::size_t getVertexCount();
 
     private:
         void storePoints();
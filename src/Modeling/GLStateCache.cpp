@@ -0,0 +1,166 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+#include "GLStateCache.hpp"
+
+
+GLStateCache* GLStateCache::singleton_ = 0;
+GLStateCache& GLStateCache::getInstance()
+{
+    if (!singleton_)
+        singleton_ = new GLStateCache();
+    return *singleton_;
+}
+
+
+
+GLStateCache::GLStateCache() :
+    issued_(0), avoided_(0)
+{
+    invalidate();
+}
+
+
+
+void GLStateCache::useProgram(GLuint program)
+{
+    if (update(program_, program))
+        glUseProgram(program);
+}
+
+
+
+//other targets are not cached, and always go through
+void GLStateCache::bindBuffer(GLenum target, GLuint buffer)
+{
+    if (target == GL_ARRAY_BUFFER)
+    {
+        if (update(arrayBuffer_, buffer))
+            glBindBuffer(target, buffer);
+    }
+    else if (target == GL_ELEMENT_ARRAY_BUFFER)
+    {
+        if (update(elementArrayBuffer_, buffer))
+            glBindBuffer(target, buffer);
+    }
+    else
+    {
+        glBindBuffer(target, buffer);
+        issued_++;
+    }
+}
+
+
+
+//the element buffer and enabled arrays are unknown in the new vertex array
+void GLStateCache::bindVertexArray(GLuint vertexArray)
+{
+    if (!update(vertexArray_, vertexArray))
+        return;
+
+    glBindVertexArray(vertexArray);
+    elementArrayBuffer_ = UNKNOWN_NAME;
+    attribArrays_.assign(attribArrays_.size(), UNKNOWN);
+}
+
+
+
+void GLStateCache::enableVertexAttribArray(GLuint index)
+{
+    if (index >= MAX_ATTRIB_ARRAYS) //such as a location of -1, left to GL
+    {
+        glEnableVertexAttribArray(index);
+        issued_++;
+        return;
+    }
+
+    if (attribArrays_.size() <= index)
+        attribArrays_.resize(index + 1, UNKNOWN);
+
+    if (attribArrays_[index] == ENABLED)
+        avoided_++;
+    else
+    {
+        glEnableVertexAttribArray(index);
+        attribArrays_[index] = ENABLED;
+        issued_++;
+    }
+}
+
+
+
+void GLStateCache::disableVertexAttribArray(GLuint index)
+{
+    if (index >= MAX_ATTRIB_ARRAYS) //such as a location of -1, left to GL
+    {
+        glDisableVertexAttribArray(index);
+        issued_++;
+        return;
+    }
+
+    if (attribArrays_.size() <= index)
+        attribArrays_.resize(index + 1, UNKNOWN);
+
+    if (attribArrays_[index] == DISABLED)
+        avoided_++;
+    else
+    {
+        glDisableVertexAttribArray(index);
+        attribArrays_[index] = DISABLED;
+        issued_++;
+    }
+}
+
+
+
+void GLStateCache::invalidate()
+{
+    program_ = arrayBuffer_ = elementArrayBuffer_ = vertexArray_ = UNKNOWN_NAME;
+    attribArrays_.assign(attribArrays_.size(), UNKNOWN);
+}
+
+
+
+//returns how many calls were passed on and dropped since the last call
+std::pair<std::size_t, std::size_t> GLStateCache::takeCallCounts()
+{
+    return std::make_pair(issued_.exchange(0), avoided_.exchange(0));
+}
+
+
+
+//returns whether the call has to go through
+bool GLStateCache::update(GLuint& cached, GLuint value)
+{
+    if (cached == value)
+    {
+        avoided_++;
+        return false;
+    }
+
+    cached = value;
+    issued_++;
+    return true;
+}
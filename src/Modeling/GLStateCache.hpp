@@ -0,0 +1,81 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+#ifndef GL_STATE_CACHE
+#define GL_STATE_CACHE
+
+/**
+    The GLStateCache remembers the program in use, the buffers bound, and
+    which vertex attribute arrays are enabled, and drops any call that would
+    set them to what they already are. The element buffer and the enabled
+    arrays belong to the bound vertex array object, so binding another one
+    forgets them. Every such call in Atomata has to go through it, or it would
+    fall out of step with the driver; invalidate() forgets everything, for
+    when something else may have changed the state. It counts the calls it
+    passed on and the ones it dropped, for the FPS report. Like OpenGL itself,
+    it must only be used from the rendering thread, though the counts may be
+    taken from any thread.
+**/
+
+#include <GL/glew.h>
+#include <vector>
+#include <utility>
+#include <atomic>
+
+class GLStateCache
+{
+    public:
+        static GLStateCache& getInstance();
+
+        void useProgram(GLuint program);
+        void bindBuffer(GLenum target, GLuint buffer);
+        void bindVertexArray(GLuint vertexArray);
+        void enableVertexAttribArray(GLuint index);
+        void disableVertexAttribArray(GLuint index);
+        void invalidate();
+
+        std::pair<std::size_t, std::size_t> takeCallCounts();
+
+    private:
+        GLStateCache();
+        bool update(GLuint& cached, GLuint value);
+
+    private:
+        enum AttribArrayState : char
+        {
+            UNKNOWN, ENABLED, DISABLED
+        };
+
+        static GLStateCache* singleton_;
+
+        const GLuint UNKNOWN_NAME = (GLuint)-1; //never a valid name
+        const GLuint MAX_ATTRIB_ARRAYS = 64; //more than any driver has
+
+        GLuint program_, arrayBuffer_, elementArrayBuffer_, vertexArray_;
+        std::vector<AttribArrayState> attribArrays_;
+        std::atomic<std::size_t> issued_, avoided_; //since the last take
+};
+
+#endif
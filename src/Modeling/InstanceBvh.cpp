@@ -0,0 +1,233 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+#include "InstanceBvh.hpp"
+#include <algorithm>
+#include <numeric>
+
+
+InstanceBvh::InstanceBvh() :
+    localCenter_(0), localRadius_(1), occlusion_(nullptr), occluded_(0)
+{}
+
+
+
+//the sphere, in model space, that every instance's geometry fits within
+void InstanceBvh::setLocalBounds(const glm::vec3& center, float radius)
+{
+    localCenter_ = center;
+    localRadius_ = radius;
+}
+
+
+
+void InstanceBvh::build(const std::vector<glm::mat4>& matrices)
+{
+    order_.resize(matrices.size());
+    std::iota(order_.begin(), order_.end(), 0);
+
+    centers_.resize(matrices.size());
+    for (std::size_t j = 0; j < matrices.size(); j++)
+        centers_[j] = glm::vec3(matrices[j] * glm::vec4(localCenter_, 1));
+
+    nodes_.clear();
+    if (!order_.empty())
+        buildNode(0, (std::uint32_t)order_.size());
+
+    refit(matrices);
+}
+
+
+
+//children come after their parents, so walking backwards visits them first
+void InstanceBvh::refit(const std::vector<glm::mat4>& matrices)
+{
+    for (std::size_t j = nodes_.size(); j-- > 0;)
+    {
+        Node& node = nodes_[j];
+        if (node.right == NO_CHILD)
+        {
+            boundInstance(matrices[order_[node.begin]], node.min, node.max);
+            for (std::uint32_t k = node.begin + 1; k < node.end; k++)
+            {
+                glm::vec3 min, max;
+                boundInstance(matrices[order_[k]], min, max);
+                node.min = glm::min(node.min, min);
+                node.max = glm::max(node.max, max);
+            }
+        }
+        else
+        {
+            const Node& left = nodes_[j + 1];
+            const Node& right = nodes_[node.right];
+            node.min = glm::min(left.min, right.min);
+            node.max = glm::max(left.max, right.max);
+        }
+    }
+}
+
+
+
+//fills 'visible' with the indices of the instances that may be on screen,
+//and returns how many were hidden behind the occluders, if given any
+std::size_t InstanceBvh::cull(const glm::mat4& viewProjection,
+                              const OcclusionMap* occlusion,
+                              std::vector<std::size_t>& visible)
+{
+    visible.clear();
+    if (nodes_.empty())
+        return 0;
+
+    //each plane is the fourth row plus or minus one of the others,
+    //with its normal pointing into the frustum
+    for (int axis = 0; axis < 3; axis++)
+    {
+        for (int side = 0; side < 2; side++)
+        {
+            float sign = side == 0 ? 1.0f : -1.0f;
+            glm::vec4 plane;
+            for (int column = 0; column < 4; column++)
+                plane[column] = viewProjection[column][3] +
+                    sign * viewProjection[column][axis];
+            planes_[axis * 2 + side] = { glm::vec3(plane), plane.w };
+        }
+    }
+
+    occlusion_ = occlusion;
+    occluded_ = 0;
+    cullNode(0, false, visible);
+    return occluded_;
+}
+
+
+
+std::size_t InstanceBvh::size()
+{
+    return order_.size();
+}
+
+
+
+void InstanceBvh::boundInstance(const glm::mat4& matrix, glm::vec3& min,
+                                glm::vec3& max)
+{
+    glm::vec3 center = glm::vec3(matrix * glm::vec4(localCenter_, 1));
+    float scale = std::max(glm::length(glm::vec3(matrix[0])),
+        std::max(glm::length(glm::vec3(matrix[1])),
+                 glm::length(glm::vec3(matrix[2]))));
+
+    glm::vec3 reach(localRadius_ * scale);
+    min = center - reach;
+    max = center + reach;
+}
+
+
+
+std::uint32_t InstanceBvh::buildNode(std::uint32_t begin, std::uint32_t end)
+{
+    auto index = (std::uint32_t)nodes_.size();
+    nodes_.push_back({ glm::vec3(0), glm::vec3(0), begin, end, NO_CHILD });
+    if (end - begin <= LEAF_SIZE)
+        return index;
+
+    glm::vec3 min = centers_[order_[begin]], max = min;
+    for (std::uint32_t j = begin + 1; j < end; j++)
+    {
+        min = glm::min(min, centers_[order_[j]]);
+        max = glm::max(max, centers_[order_[j]]);
+    }
+
+    glm::vec3 extent = max - min;
+    int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) :
+                                     (extent.y > extent.z ? 1 : 2);
+
+    std::uint32_t middle = begin + (end - begin) / 2;
+    std::nth_element(order_.begin() + begin, order_.begin() + middle,
+        order_.begin() + end, [&](std::uint32_t a, std::uint32_t b)
+        {
+            return centers_[a][axis] < centers_[b][axis];
+        }
+    );
+
+    buildNode(begin, middle);
+    std::uint32_t right = buildNode(middle, end);
+    nodes_[index].right = right;
+    return index;
+}
+
+
+
+void InstanceBvh::cullNode(std::uint32_t index, bool inside,
+                           std::vector<std::size_t>& visible)
+{
+    const Node& node = nodes_[index];
+
+    //the children of a node inside the frustum are inside it too
+    if (!inside)
+    {
+        inside = true;
+        for (const auto& plane : planes_)
+        {
+            //the corners furthest along and against the plane's normal
+            glm::vec3 nearest, furthest;
+            for (int axis = 0; axis < 3; axis++)
+            {
+                bool positive = plane.normal[axis] > 0;
+                furthest[axis] = positive ? node.max[axis] : node.min[axis];
+                nearest[axis] = positive ? node.min[axis] : node.max[axis];
+            }
+
+            if (glm::dot(plane.normal, furthest) + plane.offset < 0)
+                return; //entirely outside this plane
+            if (glm::dot(plane.normal, nearest) + plane.offset < 0)
+                inside = false;
+        }
+    }
+
+    if (occlusion_ && occlusion_->isOccluded(node.min, node.max))
+    {
+        occluded_ += node.end - node.begin;
+        return;
+    }
+
+    if (node.right == NO_CHILD || (inside && !occlusion_))
+        acceptNode(index, visible);
+    else
+    {
+        cullNode(index + 1, inside, visible);
+        cullNode(node.right, inside, visible);
+    }
+}
+
+
+
+//a subtree's instances are contiguous in order_
+void InstanceBvh::acceptNode(std::uint32_t index,
+                             std::vector<std::size_t>& visible)
+{
+    const Node& node = nodes_[index];
+    visible.insert(visible.end(), order_.begin() + node.begin,
+        order_.begin() + node.end);
+}
@@ -0,0 +1,94 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+#ifndef INSTANCE_BVH
+#define INSTANCE_BVH
+
+/**
+    An InstanceBvh is a bounding volume hierarchy over the instances of an
+    InstancedModel, for skipping the ones outside the camera's frustum. Each
+    instance is bounded by a sphere, given in model space and carried along
+    by its model matrix. build() sorts the instances into a tree of boxes by
+    splitting them in half along the widest axis, and is only needed once:
+    as the instances move, refit() recomputes the boxes bottom-up without
+    changing which instances share a box. cull() then tests the boxes
+    against the frustum planes, dropping whole subtrees that are outside and
+    accepting whole subtrees that are inside without testing their children.
+    Given an OcclusionMap, it also drops the boxes that are hidden behind
+    what was drawn into it, and returns how many instances that removed.
+**/
+
+#include "World/OcclusionMap.hpp"
+#include <vector>
+#include <cstdint>
+
+class InstanceBvh
+{
+    public:
+        InstanceBvh();
+        void setLocalBounds(const glm::vec3& center, float radius);
+        void build(const std::vector<glm::mat4>& matrices);
+        void refit(const std::vector<glm::mat4>& matrices);
+        std::size_t cull(const glm::mat4& viewProjection,
+                         const OcclusionMap* occlusion,
+                         std::vector<std::size_t>& visible);
+        std::size_t size();
+
+    private:
+        struct Node
+        {
+            glm::vec3 min, max;
+            std::uint32_t begin, end; //instances in order_, if a leaf
+            std::uint32_t right; //the left child follows its parent
+        };
+
+        struct Plane
+        {
+            glm::vec3 normal;
+            float offset;
+        };
+
+        void boundInstance(const glm::mat4& matrix, glm::vec3& min,
+                           glm::vec3& max);
+        std::uint32_t buildNode(std::uint32_t begin, std::uint32_t end);
+        void cullNode(std::uint32_t index, bool inside,
+                      std::vector<std::size_t>& visible);
+        void acceptNode(std::uint32_t index, std::vector<std::size_t>& visible);
+
+    private:
+        const std::uint32_t LEAF_SIZE = 4;
+        const std::uint32_t NO_CHILD = 0; //the root is nobody's child
+
+        glm::vec3 localCenter_;
+        float localRadius_;
+        std::vector<Node> nodes_; //depth-first, children after parents
+        std::vector<std::uint32_t> order_; //instances grouped by leaf
+        std::vector<glm::vec3> centers_; //scratch space for build()
+        Plane planes_[6]; //of the frustum being culled against
+        const OcclusionMap* occlusion_; //optional, during cull()
+        std::size_t occluded_; //instances dropped by occlusion_
+};
+
+#endif
@@ -0,0 +1,141 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+#include "InstanceStore.hpp"
+#include <algorithm>
+
+
+InstanceStore::InstanceStore() :
+    back_(0), front_(2), middle_(1), frontIsNew_(false)
+{}
+
+
+
+void InstanceStore::add(const glm::mat4& matrix)
+{
+    for (auto& buffer : buffers_)
+        buffer.push_back(matrix);
+    dirty_.push_back(false);
+}
+
+
+
+void InstanceStore::set(std::size_t index, const glm::mat4& matrix)
+{
+    buffers_[back_][index] = matrix;
+    dirty_[index] = true;
+}
+
+
+
+void InstanceStore::publish()
+{
+    collectDirtyRanges();
+    if (dirtyRanges_.empty())
+        return; //nothing changed, so the reader's frame is still current
+
+    //include every change since the last frame known to have been read,
+    //in case the reader skips some of the frames in between
+    unsigned int published = back_;
+    mergeRanges(unreadRanges_, dirtyRanges_, ranges_[published]);
+
+    unsigned int previous = middle_.exchange(published | FRESH,
+                                             std::memory_order_acq_rel);
+    back_ = previous & INDEX_MASK;
+    if (previous & FRESH) //never read, so its changes are still outstanding
+        unreadRanges_ = ranges_[published];
+    else //the reader has that frame, so it only lacks this one
+        unreadRanges_ = dirtyRanges_;
+
+    //the new back buffer is a few frames old, so bring it up to date in case
+    //the writer only changes some of the instances next time
+    buffers_[back_] = buffers_[published];
+}
+
+
+
+const std::vector<glm::mat4>& InstanceStore::acquire()
+{
+    frontIsNew_ = (middle_.load(std::memory_order_relaxed) & FRESH) != 0;
+    if (frontIsNew_)
+        front_ = middle_.exchange(front_, std::memory_order_acq_rel) & INDEX_MASK;
+    return buffers_[front_];
+}
+
+
+
+//what changed between the previous acquire() and the latest one
+const std::vector<InstanceStore::Range>& InstanceStore::getUpdatedRanges()
+{
+    static const std::vector<Range> NONE;
+    return frontIsNew_ ? ranges_[front_] : NONE;
+}
+
+
+
+//the buffers all have the same size, and it only changes during setup
+std::size_t InstanceStore::size()
+{
+    return buffers_[0].size();
+}
+
+
+
+void InstanceStore::collectDirtyRanges()
+{
+    dirtyRanges_.clear();
+    for (std::size_t j = 0; j < dirty_.size(); j++)
+    {
+        if (!dirty_[j])
+            continue;
+
+        if (!dirtyRanges_.empty() && dirtyRanges_.back().end == j)
+            dirtyRanges_.back().end = j + 1;
+        else
+            dirtyRanges_.push_back({ j, j + 1 });
+        dirty_[j] = false;
+    }
+}
+
+
+
+//union of two sorted lists of ranges, coalescing any that touch
+void InstanceStore::mergeRanges(const std::vector<Range>& a,
+                                const std::vector<Range>& b,
+                                std::vector<Range>& merged)
+{
+    merged.clear();
+    std::size_t j = 0, k = 0;
+    while (j < a.size() || k < b.size())
+    {
+        bool takeA = k == b.size() || (j < a.size() && a[j].begin < b[k].begin);
+        const Range& next = takeA ? a[j++] : b[k++];
+
+        if (!merged.empty() && next.begin <= merged.back().end)
+            merged.back().end = std::max(merged.back().end, next.end);
+        else
+            merged.push_back(next);
+    }
+}
@@ -0,0 +1,89 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+#ifndef INSTANCE_STORE
+#define INSTANCE_STORE
+
+/**
+    An InstanceStore holds the model matrices of an InstancedModel in three
+    buffers, so that the animation thread and the rendering thread never
+    touch the same one. The writer fills its back buffer with set() and then
+    publish()es it by atomically swapping it with the middle buffer. The
+    reader's acquire() swaps the middle buffer for its front buffer, but only
+    if something new was published since its last acquire(). Neither side
+    ever waits for the other, and the reader always sees a complete frame.
+    A single thread may publish(), although several may set() disjoint
+    instances of the same frame. add() resizes all three buffers, so it is
+    only safe before the animation starts.
+
+    set() also flags its instance as dirty. publish() collapses those flags
+    into sorted ranges, and getUpdatedRanges() tells the reader which ranges
+    differ from the frame it had before its last acquire(), including any
+    frames it never saw, so that uploads can be limited to those ranges.
+    Publishing a frame in which nothing was set() is a no-op.
+**/
+
+#include "glm/glm.hpp"
+#include <atomic>
+#include <vector>
+
+class InstanceStore
+{
+    public:
+        struct Range
+        {
+            std::size_t begin, end; //half-open
+        };
+
+    public:
+        InstanceStore();
+        void add(const glm::mat4& matrix);
+        void set(std::size_t index, const glm::mat4& matrix);
+        void publish();
+        const std::vector<glm::mat4>& acquire();
+        const std::vector<Range>& getUpdatedRanges();
+        std::size_t size();
+
+    private:
+        void collectDirtyRanges();
+        static void mergeRanges(const std::vector<Range>& a,
+                                const std::vector<Range>& b,
+                                std::vector<Range>& merged);
+
+    private:
+        const unsigned int INDEX_MASK = 3;
+        const unsigned int FRESH = 4; //set when the middle buffer is unread
+
+        std::vector<glm::mat4> buffers_[3];
+        std::vector<Range> ranges_[3]; //changes since the reader's last frame
+        unsigned int back_, front_; //owned by the writer and reader respectively
+        std::atomic<unsigned int> middle_;
+
+        std::vector<char> dirty_; //per instance, since the last publish()
+        std::vector<Range> dirtyRanges_, unreadRanges_; //writer's scratch
+        bool frontIsNew_; //whether the last acquire() swapped buffers
+};
+
+#endif
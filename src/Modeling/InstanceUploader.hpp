@@ -0,0 +1,97 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+#ifndef INSTANCE_UPLOADER
+#define INSTANCE_UPLOADER
+
+/**
+    An InstanceUploader decides what an InstancedModel sends to its matrix
+    buffer so that the buffer matches the frame being drawn. The first full
+    frame is sent whole, and after that only the ranges that changed since
+    the previous acquire(). A culled frame sends just its visible instances,
+    which replaces what the buffer held, so the next full frame is sent whole
+    again. So is the frame after one where every instance was culled, since
+    that frame's ranges were acquired but never sent. The sending is left to
+    the caller, which keeps these decisions free of OpenGL.
+**/
+
+#include "InstanceStore.hpp"
+#include <vector>
+
+class InstanceUploader
+{
+    public:
+        InstanceUploader();
+
+        template <typename SendAll, typename SendRange>
+        void uploadAll(const std::vector<glm::mat4>& matrices,
+                       const std::vector<InstanceStore::Range>& updated,
+                       const SendAll& sendAll, const SendRange& sendRange);
+
+        template <typename SendAll>
+        bool uploadVisible(const std::vector<glm::mat4>& visibleMatrices,
+                           const SendAll& sendAll);
+
+    private:
+        std::size_t uploaded_; //instances of a whole frame held, 0 if not
+};
+
+
+
+//sends the ranges that changed since the last frame, or everything if the
+//buffer does not hold the previous frame
+template <typename SendAll, typename SendRange>
+void InstanceUploader::uploadAll(const std::vector<glm::mat4>& matrices,
+                                 const std::vector<InstanceStore::Range>& updated,
+                                 const SendAll& sendAll,
+                                 const SendRange& sendRange)
+{
+    if (uploaded_ != matrices.size())
+    {
+        sendAll(matrices);
+        uploaded_ = matrices.size();
+        return;
+    }
+
+    for (const auto& range : updated)
+        sendRange(range);
+}
+
+
+
+//returns false, and sends nothing, if there is nothing visible to draw
+template <typename SendAll>
+bool InstanceUploader::uploadVisible(
+    const std::vector<glm::mat4>& visibleMatrices, const SendAll& sendAll)
+{
+    uploaded_ = 0; //either replaced, or missing the ranges just acquired
+    if (visibleMatrices.empty())
+        return false;
+
+    sendAll(visibleMatrices);
+    return true;
+}
+
+#endif
@@ -27,11 +27,25 @@
 #include "Modeling/Shading/Program.hpp"
 #include "glm/glm.hpp"
 #include "glm/gtc/type_ptr.hpp"
+#include "Modeling/GLStateCache.hpp"
 #include <iostream>
 
 
+bool InstancedModel::instancing_ = false;
+bool InstancedModel::vertexArrays_ = false;
+std::atomic<std::size_t> InstancedModel::drawCalls_(0);
+std::atomic<std::size_t> InstancedModel::triangles_(0);
+std::atomic<std::size_t> InstancedModel::visibleInstances_(0);
+std::atomic<std::size_t> InstancedModel::culledInstances_(0);
+std::atomic<std::size_t> InstancedModel::occludedInstances_(0);
+std::shared_ptr<OcclusionMap> InstancedModel::occlusionMap_ = nullptr;
+bool InstancedModel::occluderPass_ = false;
+
 InstancedModel::InstancedModel(const std::shared_ptr<Mesh>& mesh) :
-    mesh_(mesh), cachedHandle_(0), isVisible_(true)
+    mesh_(mesh), cachedHandle_(0), matrixAttrib_(-1), instanceDataAttrib_(-1),
+    matrixBuffer_(0), instanceDataBuffer_(0),
+    vertexArray_(0), vertexArrayHasData_(false), instanceDataChanged_(false),
+    isVisible_(true), occluder_(false)
 {}
 
 
@@ -40,7 +54,7 @@ InstancedModel::InstancedModel(const std::shared_ptr<Mesh>& mesh,
                                const glm::mat4& modelMatrix) :
     InstancedModel(mesh)
 {
-    modelMatrices_.push_back(modelMatrix);
+    modelMatrices_.add(modelMatrix);
 }
 
 
@@ -69,7 +83,8 @@ InstancedModel::InstancedModel(const std::shared_ptr<Mesh>& mesh,
                                const BufferList& optionalDBs) :
     InstancedModel(mesh)
 {
-    modelMatrices_ = modelMatrices;
+    for (const auto& matrix : modelMatrices)
+        modelMatrices_.add(matrix);
     optionalDBs_ = optionalDBs;
 }
 
@@ -79,6 +94,8 @@ void InstancedModel::saveAs(GLuint programHandle)
 {
     std::cout << "Storing Model under Program " << programHandle << ": { ";
 
+    if (vertexArrays_) //storing must not change another Model's vertex array
+        GLStateCache::getInstance().bindVertexArray(0);
     mesh_->store(programHandle);
 
     std::cout << typeid(*mesh_).name() << " ";
@@ -89,6 +106,18 @@ void InstancedModel::saveAs(GLuint programHandle)
         std::cout << typeid(*buffer).name() << " ";
     }
 
+    if (instancing_)
+    {
+        glGenBuffers(1, &matrixBuffer_);
+        glGenBuffers(1, &instanceDataBuffer_);
+    }
+
+    if (vertexArrays_)
+    {
+        locateAttributes(programHandle);
+        vertexArray_ = storeVertexArray(*mesh_, optionalDBs_, matrixBuffer_);
+    }
+
     std::cout << "}" << std::endl;
     checkGlError();
 }
@@ -97,40 +126,336 @@ void InstancedModel::saveAs(GLuint programHandle)
 
 void InstancedModel::addInstance(const glm::mat4& instanceModelMatrix)
 {
-    modelMatrices_.push_back(instanceModelMatrix);
+    modelMatrices_.add(instanceModelMatrix);
 }
 
 
 
 void InstancedModel::render(GLuint programHandle)
+{
+    locateAttributes(programHandle);
+
+    if (isVisible_ && matrixAttrib_ >= 0)
+    {
+        enableDataBuffers();
+
+        const auto& matrices = modelMatrices_.acquire(); //latest whole frame
+        if (cullInstances(matrices))
+            renderVisible(matrices);
+        else if (instancing_)
+            renderInstanced(matrices);
+        else
+            drawEach(*mesh_, matrices, instanceData_);
+    }
+}
+
+
+
+void InstancedModel::locateAttributes(GLuint programHandle)
 {
     if (cachedHandle_ != programHandle) //bit of adaptable caching
     {
         cachedHandle_ = programHandle;
-        matrixModelLocation_ = glGetUniformLocation(programHandle, "modelMatrix");
+        matrixAttrib_ = glGetAttribLocation(programHandle, "modelMatrix");
+        instanceDataAttrib_ = glGetAttribLocation(programHandle, "instanceData");
     }
+}
+
+
+
+//records the attributes of the mesh and of those buffers that only set
+//attributes, plus the matrix columns if instancing, in a new vertex array
+GLuint InstancedModel::storeVertexArray(Mesh& mesh, const BufferList& buffers,
+                                        GLuint matrixBuffer)
+{
+    auto& state = GLStateCache::getInstance();
+
+    GLuint vertexArray;
+    glGenVertexArrays(1, &vertexArray);
+    state.bindVertexArray(vertexArray);
+
+    mesh.enable();
+    for (const auto& buffer : buffers)
+        if (buffer->belongsInVertexArray())
+            buffer->enable();
+
+    if (instancing_ && matrixAttrib_ >= 0)
+        enableInstanceAttributes(matrixBuffer, false);
+
+    state.bindVertexArray(0);
+    checkGlError();
+    return vertexArray;
+}
+
 
-    if (isVisible_)
+
+//narrows visible_ down to the instances in the camera's view, and returns
+//whether any were left out. The tree is refit whenever the matrices change.
+//The occluder pass reuses the previous frame's visible_ instead.
+bool InstancedModel::cullInstances(const std::vector<glm::mat4>& matrices)
+{
+    if (!cullingCamera_)
+        return false;
+
+    if (bvh_.size() != matrices.size())
     {
-        enableDataBuffers();
+        bvh_.build(matrices);
+        visible_.clear();
+    }
+    else if (!modelMatrices_.getUpdatedRanges().empty())
+        bvh_.refit(matrices);
 
-        for (glm::mat4 modelMatrix : modelMatrices_)
+    if (occluderPass_)
+        return visible_.size() < matrices.size();
+
+    auto occluded = bvh_.cull(cullingCamera_->getProjectionMatrix() *
+        cullingCamera_->calculateViewMatrix(), occlusionMap_.get(), visible_);
+
+    visibleInstances_ += visible_.size();
+    culledInstances_ += matrices.size() - visible_.size();
+    occludedInstances_ += occluded;
+    return visible_.size() < matrices.size();
+}
+
+
+
+void InstancedModel::renderInstanced(const std::vector<glm::mat4>& matrices)
+{
+    if (matrices.empty())
+        return;
+
+    bool hasInstanceData = instanceDataAttrib_ != -1 &&
+        instanceData_.size() == matrices.size();
+
+    uploadMatrices(matrices);
+    if (hasInstanceData && instanceDataChanged_)
+        uploadInstanceData();
+
+    if (vertexArray_)
+        updateVertexArrayData(hasInstanceData);
+    else
+        enableInstanceAttributes(matrixBuffer_, hasInstanceData);
+
+    mesh_->drawInstanced((GLsizei)matrices.size());
+    countDraws(1, matrices.size() * mesh_->countTriangles());
+
+    if (!vertexArray_)
+        disableInstanceAttributes(hasInstanceData);
+}
+
+
+
+//gathers the instances that survived culling, and draws only those
+void InstancedModel::renderVisible(const std::vector<glm::mat4>& matrices)
+{
+    auto& state = GLStateCache::getInstance();
+    bool hasInstanceData = instanceDataAttrib_ != -1 &&
+        instanceData_.size() == matrices.size();
+
+    visibleMatrices_.clear();
+    visibleData_.clear();
+    for (auto index : visible_)
+    {
+        visibleMatrices_.push_back(matrices[index]);
+        if (hasInstanceData)
+            visibleData_.push_back(instanceData_[index]);
+    }
+
+    if (!instancing_)
+    {
+        drawEach(*mesh_, visibleMatrices_, visibleData_);
+        return;
+    }
+
+    //even when all were culled, the next unculled frame uploads everything
+    state.bindBuffer(GL_ARRAY_BUFFER, matrixBuffer_);
+    bool anyVisible = uploader_.uploadVisible(visibleMatrices_,
+        [](const std::vector<glm::mat4>& visible)
         {
-            glUniformMatrix4fv(matrixModelLocation_, 1, GL_FALSE,
-                glm::value_ptr(modelMatrix));
-            mesh_->draw();
+            glBufferData(GL_ARRAY_BUFFER, visible.size() * sizeof(glm::mat4),
+                visible.data(), GL_STREAM_DRAW);
+        });
+    if (!anyVisible)
+        return;
+
+    if (hasInstanceData)
+    {
+        state.bindBuffer(GL_ARRAY_BUFFER, instanceDataBuffer_);
+        glBufferData(GL_ARRAY_BUFFER, visibleData_.size() * sizeof(glm::vec4),
+            visibleData_.data(), GL_STREAM_DRAW);
+        instanceDataChanged_ = true;
+    }
+
+    if (vertexArray_)
+        updateVertexArrayData(hasInstanceData);
+    else
+        enableInstanceAttributes(matrixBuffer_, hasInstanceData);
+
+    mesh_->drawInstanced((GLsizei)visibleMatrices_.size());
+    countDraws(1, visibleMatrices_.size() * mesh_->countTriangles());
+
+    if (!vertexArray_)
+        disableInstanceAttributes(hasInstanceData);
+}
+
+
+
+//the fallback: constant attributes, and one draw call per instance
+void InstancedModel::drawEach(Mesh& mesh,
+                              const std::vector<glm::mat4>& matrices,
+                              const std::vector<glm::vec4>& instanceData)
+{
+    auto& state = GLStateCache::getInstance();
+    bool hasInstanceData = instanceDataAttrib_ != -1 &&
+        instanceData.size() == matrices.size();
+
+    //arrays left enabled by other Programs would override the constants,
+    //which cannot happen in a vertex array that never enabled them
+    if (!vertexArrays_)
+    {
+        for (GLuint column = 0; column < 4; column++)
+            state.disableVertexAttribArray(matrixAttrib_ + column);
+        if (hasInstanceData)
+            state.disableVertexAttribArray(instanceDataAttrib_);
+    }
+
+    for (std::size_t j = 0; j < matrices.size(); j++)
+    {
+        for (GLuint column = 0; column < 4; column++)
+            glVertexAttrib4fv(matrixAttrib_ + column,
+                glm::value_ptr(matrices[j][column]));
+        if (hasInstanceData)
+            glVertexAttrib4fv(instanceDataAttrib_,
+                glm::value_ptr(instanceData[j]));
+        mesh.draw();
+    }
+
+    countDraws(matrices.size(), matrices.size() * mesh.countTriangles());
+}
+
+
+
+//sends the ranges that changed since the last frame, or everything at first
+void InstancedModel::uploadMatrices(const std::vector<glm::mat4>& matrices)
+{
+    GLStateCache::getInstance().bindBuffer(GL_ARRAY_BUFFER, matrixBuffer_);
+    uploader_.uploadAll(matrices, modelMatrices_.getUpdatedRanges(),
+        [](const std::vector<glm::mat4>& all)
+        {
+            glBufferData(GL_ARRAY_BUFFER, all.size() * sizeof(glm::mat4),
+                all.data(), GL_DYNAMIC_DRAW);
+        },
+        [&](const InstanceStore::Range& range)
+        {
+            glBufferSubData(GL_ARRAY_BUFFER, range.begin * sizeof(glm::mat4),
+                (range.end - range.begin) * sizeof(glm::mat4),
+                &matrices[range.begin]);
         }
+    );
+}
+
+
+
+void InstancedModel::uploadInstanceData()
+{
+    GLStateCache::getInstance().bindBuffer(GL_ARRAY_BUFFER, instanceDataBuffer_);
+    glBufferData(GL_ARRAY_BUFFER, instanceData_.size() * sizeof(glm::vec4),
+        instanceData_.data(), GL_STATIC_DRAW);
+    instanceDataChanged_ = false;
+}
+
+
+
+//a mat4 attribute occupies four consecutive locations, one per column
+void InstancedModel::enableInstanceAttributes(GLuint matrixBuffer,
+                                              bool hasInstanceData)
+{
+    auto& state = GLStateCache::getInstance();
+    state.bindBuffer(GL_ARRAY_BUFFER, matrixBuffer);
+    for (GLuint column = 0; column < 4; column++)
+    {
+        GLuint attrib = matrixAttrib_ + column;
+        state.enableVertexAttribArray(attrib);
+        glVertexAttribPointer(attrib, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+            (const GLvoid*)(sizeof(glm::vec4) * column));
+        glVertexAttribDivisorARB(attrib, 1);
+    }
+
+    if (hasInstanceData)
+    {
+        state.bindBuffer(GL_ARRAY_BUFFER, instanceDataBuffer_);
+        state.enableVertexAttribArray(instanceDataAttrib_);
+        glVertexAttribPointer(instanceDataAttrib_, 4, GL_FLOAT, GL_FALSE, 0, 0);
+        glVertexAttribDivisorARB(instanceDataAttrib_, 1);
+    }
+}
+
+
+
+//the next Program may use these locations for per-vertex data
+void InstancedModel::disableInstanceAttributes(bool hasInstanceData)
+{
+    auto& state = GLStateCache::getInstance();
+    for (GLuint column = 0; column < 4; column++)
+    {
+        glVertexAttribDivisorARB(matrixAttrib_ + column, 0);
+        state.disableVertexAttribArray(matrixAttrib_ + column);
+    }
+
+    if (hasInstanceData)
+    {
+        glVertexAttribDivisorARB(instanceDataAttrib_, 0);
+        state.disableVertexAttribArray(instanceDataAttrib_);
     }
 }
 
 
 
+//the vertex array holds the matrix columns, but has to gain or lose the
+//instanceData array as the data comes and goes
+void InstancedModel::updateVertexArrayData(bool hasInstanceData)
+{
+    if (hasInstanceData == vertexArrayHasData_)
+        return;
+
+    auto& state = GLStateCache::getInstance();
+    if (hasInstanceData)
+    {
+        state.bindBuffer(GL_ARRAY_BUFFER, instanceDataBuffer_);
+        state.enableVertexAttribArray(instanceDataAttrib_);
+        glVertexAttribPointer(instanceDataAttrib_, 4, GL_FLOAT, GL_FALSE, 0, 0);
+        glVertexAttribDivisorARB(instanceDataAttrib_, 1);
+    }
+    else
+    {
+        glVertexAttribDivisorARB(instanceDataAttrib_, 0);
+        state.disableVertexAttribArray(instanceDataAttrib_);
+    }
+
+    vertexArrayHasData_ = hasInstanceData;
+}
+
+
+
 void InstancedModel::enableDataBuffers()
 {
-    mesh_->enable();
+    enableBuffers(vertexArray_, *mesh_, optionalDBs_);
+}
 
-    for (auto buffer : optionalDBs_)
-        buffer->enable();
+
+
+//with a vertex array, only the buffers that set uniforms or textures are left
+void InstancedModel::enableBuffers(GLuint vertexArray, Mesh& mesh,
+                                   const BufferList& buffers)
+{
+    if (vertexArray)
+        GLStateCache::getInstance().bindVertexArray(vertexArray);
+    else
+        mesh.enable();
+
+    for (const auto& buffer : buffers)
+        if (!vertexArray || !buffer->belongsInVertexArray())
+            buffer->enable();
 }
 
 
@@ -139,7 +464,7 @@ void InstancedModel::disableDataBuffers()
 {
     mesh_->disable();
 
-    for (auto buffer : optionalDBs_)
+    for (const auto& buffer : optionalDBs_)
         buffer->disable();
 }
 
@@ -147,7 +472,33 @@ void InstancedModel::disableDataBuffers()
 
 void InstancedModel::setModelMatrix(std::size_t index, const glm::mat4& matrix)
 {
-    modelMatrices_[index] = matrix;
+    modelMatrices_.set(index, matrix);
+}
+
+
+
+//makes the matrices set since the last call visible to render()
+void InstancedModel::publishModelMatrices()
+{
+    modelMatrices_.publish();
+}
+
+
+
+//for writers that set() and publish() the matrices without the model
+InstanceStore& InstancedModel::getModelMatrices()
+{
+    return modelMatrices_;
+}
+
+
+
+void InstancedModel::setInstanceData(std::size_t index, const glm::vec4& data)
+{
+    if (instanceData_.size() <= index)
+        instanceData_.resize(index + 1);
+    instanceData_[index] = data;
+    instanceDataChanged_ = true;
 }
 
 
@@ -160,6 +511,38 @@ void InstancedModel::setVisible(bool visible)
 
 
 
+//skips the instances outside the camera's view, each of which must fit
+//within the given sphere in model space
+void InstancedModel::cullAgainst(const std::shared_ptr<Camera>& camera,
+                                 const glm::vec3& center, float radius)
+{
+    cullingCamera_ = camera;
+    bvh_.setLocalBounds(center, radius);
+}
+
+
+
+void InstancedModel::setOccluder(bool occluder)
+{
+    occluder_ = occluder;
+}
+
+
+
+bool InstancedModel::isOccluder()
+{
+    return occluder_;
+}
+
+
+
+std::shared_ptr<Mesh> InstancedModel::getMesh()
+{
+    return mesh_;
+}
+
+
+
 BufferList InstancedModel::getOptionalDataBuffers()
 {
     return optionalDBs_;
@@ -171,3 +554,89 @@ std::size_t InstancedModel::getInstanceCount()
 {
     return modelMatrices_.size();
 }
+
+
+
+bool InstancedModel::isInstancingSupported()
+{
+    return GLEW_ARB_instanced_arrays && GLEW_ARB_draw_instanced;
+}
+
+
+
+//applies to the models saved afterwards, so it must be set before any are
+void InstancedModel::setInstancing(bool enabled)
+{
+    instancing_ = enabled;
+}
+
+
+
+bool InstancedModel::isVertexArraySupported()
+{
+    return GLEW_ARB_vertex_array_object;
+}
+
+
+
+//like instancing, this has to be set before any Models are saved
+void InstancedModel::setVertexArrays(bool enabled)
+{
+    vertexArrays_ = enabled;
+}
+
+
+
+//returns how many draw calls were issued since the last call
+std::size_t InstancedModel::takeDrawCallCount()
+{
+    return drawCalls_.exchange(0);
+}
+
+
+
+//returns how many triangles were submitted since the last call
+std::size_t InstancedModel::takeTriangleCount()
+{
+    return triangles_.exchange(0);
+}
+
+
+
+//returns how many instances were drawn and culled since the last call
+std::pair<std::size_t, std::size_t> InstancedModel::takeCullingCounts()
+{
+    return std::make_pair(visibleInstances_.exchange(0),
+                          culledInstances_.exchange(0));
+}
+
+
+
+//returns how many of the culled instances were hidden behind others
+std::size_t InstancedModel::takeOcclusionCount()
+{
+    return occludedInstances_.exchange(0);
+}
+
+
+
+void InstancedModel::setOcclusionMap(const std::shared_ptr<OcclusionMap>& map)
+{
+    occlusionMap_ = map;
+}
+
+
+
+//while set, occluders draw what was visible last frame, and nobody culls
+void InstancedModel::setOccluderPass(bool occluderPass)
+{
+    occluderPass_ = occluderPass;
+}
+
+
+
+void InstancedModel::countDraws(std::size_t calls, std::size_t triangles)
+{
+    drawCalls_ += calls;
+    triangles_ += triangles;
+}
@@ -26,10 +26,32 @@
 #ifndef INSTANCED_MODEL
 #define INSTANCED_MODEL
 
+/**
+    An InstancedModel draws the same Mesh at many places at once, each with
+    its own model matrix and optional instanceData. When hardware instancing
+    is available, the matrices live in a vertex buffer whose attributes
+    advance once per instance, and the whole model is a single draw call;
+    only the ranges of matrices that changed are re-uploaded. Otherwise the
+    same shader attributes are set to constant values before drawing each
+    instance on its own. Where vertex array objects are supported, saveAs()
+    records the Mesh's attributes, those of its buffers, and the matrix
+    columns in one, so that drawing starts with a single bind. A model told
+    to cullAgainst() a Camera keeps an InstanceBvh over its instances, and
+    only draws those that may be in view and, once the Scene has an
+    OcclusionMap, not hidden behind occluders. During the Scene's occluder
+    pass, occluders redraw the instances that were visible in the previous
+    frame.
+**/
+
 #include "Modeling/Mesh/Mesh.hpp"
 #include "Modeling/DataBuffers/OptionalDataBuffer.hpp"
+#include "InstanceStore.hpp"
+#include "InstanceUploader.hpp"
+#include "InstanceBvh.hpp"
+#include "World/Camera.hpp"
 #include <vector>
 #include <memory>
+#include <atomic>
 
 typedef std::vector<std::shared_ptr<OptionalDataBuffer>> BufferList;
 
@@ -50,23 +72,82 @@ class InstancedModel
 
         virtual void saveAs(GLuint programHandle);
         void addInstance(const glm::mat4& instanceModelMatrix);
-        void render(GLuint programHandle);
+        virtual void render(GLuint programHandle);
         void setModelMatrix(std::size_t index, const glm::mat4& matrix);
+        void publishModelMatrices();
+        InstanceStore& getModelMatrices();
+        void setInstanceData(std::size_t index, const glm::vec4& data);
         void setVisible(bool visible);
+        void cullAgainst(const std::shared_ptr<Camera>& camera,
+                         const glm::vec3& center, float radius);
+        void setOccluder(bool occluder);
+        bool isOccluder();
+        std::shared_ptr<Mesh> getMesh();
         BufferList getOptionalDataBuffers();
         std::size_t getInstanceCount();
 
+        static bool isInstancingSupported();
+        static void setInstancing(bool enabled);
+        static bool isVertexArraySupported();
+        static void setVertexArrays(bool enabled);
+        static std::size_t takeDrawCallCount();
+        static std::size_t takeTriangleCount();
+        static std::pair<std::size_t, std::size_t> takeCullingCounts();
+        static std::size_t takeOcclusionCount();
+        static void setOcclusionMap(const std::shared_ptr<OcclusionMap>& map);
+        static void setOccluderPass(bool occluderPass);
+
     private:
         void enableDataBuffers();
         void disableDataBuffers();
+        void updateVertexArrayData(bool hasInstanceData);
+        void renderInstanced(const std::vector<glm::mat4>& matrices);
+        void renderVisible(const std::vector<glm::mat4>& matrices);
+        void uploadMatrices(const std::vector<glm::mat4>& matrices);
+        void uploadInstanceData();
+
+    protected:
+        void locateAttributes(GLuint programHandle);
+        GLuint storeVertexArray(Mesh& mesh, const BufferList& buffers,
+                                GLuint matrixBuffer);
+        void enableBuffers(GLuint vertexArray, Mesh& mesh,
+                           const BufferList& buffers);
+        bool cullInstances(const std::vector<glm::mat4>& matrices);
+        void drawEach(Mesh& mesh, const std::vector<glm::mat4>& matrices,
+                      const std::vector<glm::vec4>& instanceData);
+        void enableInstanceAttributes(GLuint matrixBuffer, bool hasInstanceData);
+        void disableInstanceAttributes(bool hasInstanceData);
+        static void countDraws(std::size_t calls, std::size_t triangles);
 
     protected:
         std::shared_ptr<Mesh> mesh_;
-        std::vector<glm::mat4> modelMatrices_;
+        InstanceStore modelMatrices_; //written by animation, read by render
+        std::vector<glm::vec4> instanceData_; //optional, for the shaders
         BufferList optionalDBs_;
         GLuint cachedHandle_;
-        GLint matrixModelLocation_;
+        GLint matrixAttrib_, instanceDataAttrib_; //matrices take four
+        GLuint matrixBuffer_, instanceDataBuffer_; //if instancing
+        InstanceUploader uploader_; //what matrixBuffer_ holds
+        GLuint vertexArray_; //if vertex arrays are used
+        bool vertexArrayHasData_; //whether it has the instanceData array
+        bool instanceDataChanged_;
         bool isVisible_;
+
+        std::shared_ptr<Camera> cullingCamera_; //optional
+        InstanceBvh bvh_;
+        std::vector<std::size_t> visible_; //instances that survived culling
+        std::vector<glm::mat4> visibleMatrices_; //gathered from visible_
+        std::vector<glm::vec4> visibleData_; //gathered from visible_
+        bool occluder_; //drawn in the occluder pass
+
+        static bool instancing_;
+        static bool vertexArrays_;
+        static std::atomic<std::size_t> drawCalls_; //since the last take
+        static std::atomic<std::size_t> triangles_; //since the last take
+        static std::atomic<std::size_t> visibleInstances_, culledInstances_;
+        static std::atomic<std::size_t> occludedInstances_; //of the culled
+        static std::shared_ptr<OcclusionMap> occlusionMap_; //optional
+        static bool occluderPass_;
 };
 
 typedef std::shared_ptr<InstancedModel> InstancedModelPtr;
@@ -0,0 +1,175 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+#include "LodModel.hpp"
+#include "Modeling/GLStateCache.hpp"
+#include <iostream>
+#include <limits>
+
+
+LodModel::LodModel(const std::vector<Level>& levels,
+                   const std::shared_ptr<Camera>& camera) :
+    InstancedModel(levels.front().mesh, levels.front().buffers),
+    levels_(levels), camera_(camera), batches_(levels.size())
+{}
+
+
+
+LodModel::LodModel(const std::vector<Level>& levels,
+                   const std::shared_ptr<Camera>& camera,
+                   const glm::mat4& modelMatrix) :
+    InstancedModel(levels.front().mesh, modelMatrix, levels.front().buffers),
+    levels_(levels), camera_(camera), batches_(levels.size())
+{}
+
+
+
+//the first level is stored as the InstancedModel itself
+void LodModel::saveAs(GLuint programHandle)
+{
+    InstancedModel::saveAs(programHandle);
+
+    for (std::size_t j = 1; j < levels_.size(); j++)
+    {
+        levels_[j].mesh->store(programHandle);
+        for (const auto& buffer : levels_[j].buffers)
+            buffer->store(programHandle);
+    }
+
+    if (instancing_)
+    {
+        batchBuffers_.resize(levels_.size());
+        glGenBuffers((GLsizei)batchBuffers_.size(), batchBuffers_.data());
+    }
+
+    if (vertexArrays_) //each level draws its own batch of matrices
+        for (std::size_t j = 0; j < levels_.size(); j++)
+            levelArrays_.push_back(storeVertexArray(*levels_[j].mesh,
+                levels_[j].buffers, instancing_ ? batchBuffers_[j] : 0));
+
+    std::cout << "Stored " << levels_.size() << " levels of detail." << std::endl;
+}
+
+
+
+void LodModel::render(GLuint programHandle)
+{
+    locateAttributes(programHandle);
+
+    if (isVisible_ && matrixAttrib_ >= 0)
+    {
+        const auto& matrices = modelMatrices_.acquire();
+        assignLevels(matrices, cullInstances(matrices));
+
+        for (std::size_t j = 0; j < levels_.size(); j++)
+            if (!batches_[j].empty())
+                renderLevel(j);
+    }
+}
+
+
+
+//sorts the instances into one batch per level, by their size on screen,
+//leaving out any that were culled
+void LodModel::assignLevels(const std::vector<glm::mat4>& matrices,
+                            bool culled)
+{
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    //pixels covered by one unit of size at unit distance from the camera
+    float pixelsPerUnit = camera_->getProjectionMatrix()[1][1] * viewport[3] / 2;
+    glm::vec3 cameraPosition = camera_->getPosition();
+
+    for (auto& batch : batches_)
+        batch.clear();
+    assigned_.resize(matrices.size(), UNASSIGNED);
+
+    std::size_t count = culled ? visible_.size() : matrices.size();
+    for (std::size_t k = 0; k < count; k++)
+    {
+        //the x axis holds the girth that the tessellation has to round off
+        std::size_t j = culled ? visible_[k] : k;
+        const glm::mat4& matrix = matrices[j];
+        float size = glm::length(glm::vec3(matrix[0]));
+        float distance = glm::distance(glm::vec3(matrix[3]), cameraPosition);
+        float screenRadius = distance > 0 ? size * pixelsPerUnit / distance :
+            std::numeric_limits<float>::infinity();
+
+        assigned_[j] = (unsigned char)chooseLevel(screenRadius, assigned_[j]);
+        batches_[assigned_[j]].push_back(matrix);
+    }
+}
+
+
+
+std::size_t LodModel::chooseLevel(float screenRadius, std::size_t current)
+{
+    if (current < levels_.size())
+    {
+        float lower = levels_[current].minScreenRadius / HYSTERESIS;
+        float upper = current == 0 ? std::numeric_limits<float>::infinity() :
+            levels_[current - 1].minScreenRadius * HYSTERESIS;
+        if (screenRadius >= lower && screenRadius < upper)
+            return current;
+    }
+
+    std::size_t level = 0;
+    while (level + 1 < levels_.size() &&
+           screenRadius < levels_[level].minScreenRadius)
+        level++;
+    return level;
+}
+
+
+
+void LodModel::renderLevel(std::size_t index)
+{
+    Level& level = levels_[index];
+    const auto& batch = batches_[index];
+
+    GLuint vertexArray = levelArrays_.empty() ? 0 : levelArrays_[index];
+    enableBuffers(vertexArray, *level.mesh, level.buffers);
+
+    if (!instancing_)
+    {
+        drawEach(*level.mesh, batch, NO_INSTANCE_DATA);
+        return;
+    }
+
+    //the batches are regrouped every frame, so they are sent whole
+    GLStateCache::getInstance().bindBuffer(GL_ARRAY_BUFFER, batchBuffers_[index]);
+    glBufferData(GL_ARRAY_BUFFER, batch.size() * sizeof(glm::mat4),
+        batch.data(), GL_STREAM_DRAW);
+
+    if (!vertexArray)
+        enableInstanceAttributes(batchBuffers_[index], false);
+
+    level.mesh->drawInstanced((GLsizei)batch.size());
+    countDraws(1, batch.size() * level.mesh->countTriangles());
+
+    if (!vertexArray)
+        disableInstanceAttributes(false);
+}
@@ -0,0 +1,82 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+#ifndef LOD_MODEL
+#define LOD_MODEL
+
+/**
+    A LodModel is an InstancedModel that holds several tessellations of the
+    same shape, from finest to coarsest. Every frame, each instance is given
+    the coarsest level that still holds up at its projected size on screen,
+    and the instances are drawn as one batch per level. Each level carries
+    its own buffers, since per-vertex data has to match that level's mesh.
+    An instance keeps its level until its size moves clearly past one of the
+    level's bounds, so instances near a threshold do not flicker between two.
+**/
+
+#include "InstancedModel.hpp"
+#include "World/Camera.hpp"
+
+class LodModel : public InstancedModel
+{
+    public:
+        struct Level
+        {
+            std::shared_ptr<Mesh> mesh;
+            BufferList buffers; //matching the mesh's vertices
+            float minScreenRadius; //in pixels, for this level to be chosen
+        };
+
+    public:
+        LodModel(const std::vector<Level>& levels,
+                 const std::shared_ptr<Camera>& camera);
+        LodModel(const std::vector<Level>& levels,
+                 const std::shared_ptr<Camera>& camera,
+                 const glm::mat4& modelMatrix);
+
+        virtual void saveAs(GLuint programHandle);
+        virtual void render(GLuint programHandle);
+
+    private:
+        void assignLevels(const std::vector<glm::mat4>& matrices, bool culled);
+        std::size_t chooseLevel(float screenRadius, std::size_t current);
+        void renderLevel(std::size_t index);
+
+    private:
+        std::vector<Level> levels_;
+        std::shared_ptr<Camera> camera_;
+        std::vector<unsigned char> assigned_; //each instance's current level
+        std::vector<std::vector<glm::mat4>> batches_; //reused every frame
+        std::vector<GLuint> batchBuffers_; //if instancing
+        std::vector<GLuint> levelArrays_; //if vertex arrays are used
+        const std::vector<glm::vec4> NO_INSTANCE_DATA; //never used with LOD
+
+        const float HYSTERESIS = 1.2f; //how far past a bound before switching
+        const unsigned char UNASSIGNED = 255;
+};
+
+typedef std::shared_ptr<LodModel> LodModelPtr;
+
+#endif
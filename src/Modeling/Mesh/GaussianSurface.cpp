@@ -0,0 +1,422 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+#include "GaussianSurface.hpp"
+#include "Threading/ThreadPool.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <cmath>
+
+
+GaussianSurface::GaussianSurface(const std::vector<float>& radii,
+                                 const std::vector<glm::vec3>& colors,
+                                 const glm::vec3& minimum,
+                                 const glm::vec3& maximum) :
+    radii_(radii), colors_(colors)
+{
+    if (radii_.size() != colors_.size())
+        throw std::runtime_error("Expected one color per atom radius!");
+
+    float margin = GRID_SPACING;
+    for (auto radius : radii_)
+        margin = std::max(margin, radius * REACH);
+
+    origin_ = minimum - glm::vec3(margin);
+    glm::vec3 size = maximum - minimum + glm::vec3(2 * margin);
+    nBricks_ = glm::max(glm::ivec3(1),
+        glm::ivec3(glm::ceil(size / (GRID_SPACING * (float)BRICK_CELLS))));
+
+    bricks_.resize((std::size_t)(nBricks_.x * nBricks_.y * nBricks_.z));
+    brickAtoms_.resize(bricks_.size());
+}
+
+
+
+//returns how many bricks had to be re-meshed
+std::size_t GaussianSurface::update(const std::vector<glm::vec3>& positions)
+{
+    if (positions.size() != radii_.size())
+        throw std::runtime_error("Expected one position per atom!");
+
+    std::vector<bool> dirty(bricks_.size(), positions_.empty());
+    if (positions_.empty())
+        positions_ = positions;
+    else
+    {
+        for (std::size_t j = 0; j < positions.size(); j++)
+        {
+            if (glm::distance(positions[j], positions_[j]) > MOVEMENT_TOLERANCE)
+            {
+                markBricks(positions_[j], radii_[j] * REACH, dirty);
+                markBricks(positions[j], radii_[j] * REACH, dirty);
+                positions_[j] = positions[j];
+            }
+        }
+    }
+
+    std::vector<std::size_t> dirtyBricks;
+    for (std::size_t j = 0; j < bricks_.size(); j++)
+    {
+        if (dirty[j])
+        {
+            dirtyBricks.push_back(j);
+            brickAtoms_[j].clear();
+        }
+    }
+
+    if (dirtyBricks.empty())
+        return 0;
+
+    //sort the atoms into the dirty bricks that they reach
+    for (std::size_t j = 0; j < positions_.size(); j++)
+    {
+        glm::ivec3 low, high;
+        getBrickRange(positions_[j], radii_[j] * REACH, low, high);
+        for (int z = low.z; z <= high.z; z++)
+        {
+            for (int y = low.y; y <= high.y; y++)
+            {
+                for (int x = low.x; x <= high.x; x++)
+                {
+                    auto index = (std::size_t)((z * nBricks_.y + y) * nBricks_.x + x);
+                    if (dirty[index])
+                        brickAtoms_[index].push_back(j);
+                }
+            }
+        }
+    }
+
+    ThreadPool::getInstance().parallelFor(dirtyBricks.size(), 1,
+        [&](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t j = begin; j < end; j++)
+                meshBrick(dirtyBricks[j], brickAtoms_[dirtyBricks[j]]);
+        }
+    );
+
+    return dirtyBricks.size();
+}
+
+
+
+void GaussianSurface::getMesh(std::vector<glm::vec3>& vertices,
+                              std::vector<glm::vec3>& normals,
+                              std::vector<glm::vec3>& colors,
+                              std::vector<GLuint>& indices)
+{
+    vertices.clear();
+    normals.clear();
+    colors.clear();
+    indices.clear();
+
+    for (const auto& brick : bricks_)
+    {
+        auto offset = (GLuint)vertices.size();
+        vertices.insert(vertices.end(), brick.vertices.begin(), brick.vertices.end());
+        normals.insert(normals.end(), brick.normals.begin(), brick.normals.end());
+        colors.insert(colors.end(), brick.colors.begin(), brick.colors.end());
+        for (auto index : brick.indices)
+            indices.push_back(index + offset);
+    }
+}
+
+
+
+std::size_t GaussianSurface::countBricks()
+{
+    return bricks_.size();
+}
+
+
+
+std::size_t GaussianSurface::countTriangles()
+{
+    std::size_t count = 0;
+    for (const auto& brick : bricks_)
+        count += brick.indices.size() / 3;
+    return count;
+}
+
+
+
+void GaussianSurface::markBricks(const glm::vec3& position, float reach,
+                                 std::vector<bool>& marks)
+{
+    glm::ivec3 low, high;
+    getBrickRange(position, reach, low, high);
+    for (int z = low.z; z <= high.z; z++)
+        for (int y = low.y; y <= high.y; y++)
+            for (int x = low.x; x <= high.x; x++)
+                marks[(std::size_t)((z * nBricks_.y + y) * nBricks_.x + x)] = true;
+}
+
+
+
+void GaussianSurface::getBrickRange(const glm::vec3& position, float reach,
+                                    glm::ivec3& low, glm::ivec3& high)
+{
+    float brickLength = GRID_SPACING * (float)BRICK_CELLS;
+    low  = glm::ivec3(glm::floor((position - reach - origin_) / brickLength));
+    high = glm::ivec3(glm::floor((position + reach - origin_) / brickLength));
+    low  = glm::clamp(low,  glm::ivec3(0), nBricks_ - 1);
+    high = glm::clamp(high, glm::ivec3(0), nBricks_ - 1);
+}
+
+
+
+void GaussianSurface::meshBrick(std::size_t brickIndex, const AtomList& atoms)
+{
+    const int SAMPLES = BRICK_CELLS + 1; //along each side
+    auto index = (int)brickIndex;
+    glm::ivec3 coordinates(index % nBricks_.x, (index / nBricks_.x) % nBricks_.y,
+                           index / (nBricks_.x * nBricks_.y));
+    glm::vec3 base = origin_ +
+        glm::vec3(coordinates * BRICK_CELLS) * GRID_SPACING;
+
+    std::vector<float> density((std::size_t)(SAMPLES * SAMPLES * SAMPLES), 0);
+    std::vector<glm::vec3> positions(density.size());
+    for (int z = 0; z < SAMPLES; z++)
+        for (int y = 0; y < SAMPLES; y++)
+            for (int x = 0; x < SAMPLES; x++)
+                positions[(std::size_t)((z * SAMPLES + y) * SAMPLES + x)] =
+                    base + glm::vec3(x, y, z) * GRID_SPACING;
+
+    //splat each atom onto the samples within its reach
+    for (auto atom : atoms)
+    {
+        auto center = positions_[atom];
+        float inverseRadius2 = 1 / (radii_[atom] * radii_[atom]);
+        float reach = radii_[atom] * REACH;
+
+        auto low = glm::max(glm::ivec3(0),
+            glm::ivec3(glm::ceil((center - reach - base) / GRID_SPACING)));
+        auto high = glm::min(glm::ivec3(SAMPLES - 1),
+            glm::ivec3(glm::floor((center + reach - base) / GRID_SPACING)));
+
+        for (int z = low.z; z <= high.z; z++)
+        {
+            for (int y = low.y; y <= high.y; y++)
+            {
+                for (int x = low.x; x <= high.x; x++)
+                {
+                    auto sample = (std::size_t)((z * SAMPLES + y) * SAMPLES + x);
+                    auto offset = positions[sample] - center;
+                    float distance2 = glm::dot(offset, offset);
+                    if (distance2 < reach * reach)
+                        density[sample] += std::exp(BLOBBINESS *
+                                                (distance2 * inverseRadius2 - 1));
+                }
+            }
+        }
+    }
+
+    //each cell is split into six tetrahedra around its main diagonal, which
+    //also splits neighboring cells' shared faces along the same diagonal
+    static const int TETRAHEDRA[6][4] = {
+        {0, 1, 3, 7}, {0, 3, 2, 7}, {0, 2, 6, 7},
+        {0, 6, 4, 7}, {0, 4, 5, 7}, {0, 5, 1, 7}
+    };
+
+    Brick& brick = bricks_[brickIndex];
+    brick.vertices.clear();
+    brick.normals.clear();
+    brick.colors.clear();
+    brick.indices.clear();
+
+    EdgeMap edgeVertices;
+    for (int z = 0; z < BRICK_CELLS; z++)
+    {
+        for (int y = 0; y < BRICK_CELLS; y++)
+        {
+            for (int x = 0; x < BRICK_CELLS; x++)
+            {
+                int cube[8], nInside = 0;
+                for (int c = 0; c < 8; c++)
+                {
+                    cube[c] = ((z + (c >> 2 & 1)) * SAMPLES +
+                               (y + (c >> 1 & 1))) * SAMPLES + x + (c & 1);
+                    if (density[(std::size_t)cube[c]] > ISOVALUE)
+                        nInside++;
+                }
+
+                if (nInside == 0 || nInside == 8)
+                    continue;
+
+                for (const auto& tetrahedron : TETRAHEDRA)
+                {
+                    const int corners[4] = {
+                        cube[tetrahedron[0]], cube[tetrahedron[1]],
+                        cube[tetrahedron[2]], cube[tetrahedron[3]]
+                    };
+                    addTetrahedron(corners, density.data(), positions.data(),
+                                   atoms, edgeVertices, brick);
+                }
+            }
+        }
+    }
+}
+
+
+
+void GaussianSurface::addTetrahedron(const int corners[4],
+                                     const float density[],
+                                     const glm::vec3 positions[],
+                                     const AtomList& atoms,
+                                     EdgeMap& edgeVertices, Brick& brick)
+{
+    int inside[4], outside[4], nInside = 0, nOutside = 0;
+    for (int j = 0; j < 4; j++)
+    {
+        if (density[corners[j]] > ISOVALUE)
+            inside[nInside++] = corners[j];
+        else
+            outside[nOutside++] = corners[j];
+    }
+
+    if (nInside == 0 || nOutside == 0)
+        return;
+
+    auto vertex = [&](int a, int b)
+    {
+        return addVertex(a, b, density, positions, atoms, edgeVertices, brick);
+    };
+
+    GLuint polygon[4];
+    int nVertices = 3;
+    if (nInside == 1)
+    {
+        for (int j = 0; j < 3; j++)
+            polygon[j] = vertex(inside[0], outside[j]);
+    }
+    else if (nOutside == 1)
+    {
+        for (int j = 0; j < 3; j++)
+            polygon[j] = vertex(inside[j], outside[0]);
+    }
+    else
+    { //a quad, walked around its perimeter
+        polygon[0] = vertex(inside[0], outside[0]);
+        polygon[1] = vertex(inside[0], outside[1]);
+        polygon[2] = vertex(inside[1], outside[1]);
+        polygon[3] = vertex(inside[1], outside[0]);
+        nVertices = 4;
+    }
+
+    //wind the triangles counter-clockwise when seen from outside the surface
+    glm::vec3 outward(0);
+    for (int j = 0; j < nOutside; j++)
+        outward += positions[outside[j]] / (float)nOutside;
+    for (int j = 0; j < nInside; j++)
+        outward -= positions[inside[j]] / (float)nInside;
+
+    for (int j = 2; j < nVertices; j++)
+    {
+        GLuint a = polygon[0], b = polygon[j - 1], c = polygon[j];
+        auto normal = glm::cross(brick.vertices[b] - brick.vertices[a],
+                                 brick.vertices[c] - brick.vertices[a]);
+        if (glm::dot(normal, outward) < 0)
+            std::swap(b, c);
+
+        brick.indices.push_back(a);
+        brick.indices.push_back(b);
+        brick.indices.push_back(c);
+    }
+}
+
+
+
+//the vertex where the surface crosses between two samples, shared by all
+//tetrahedra that use that edge
+GLuint GaussianSurface::addVertex(int sampleA, int sampleB,
+                                  const float density[],
+                                  const glm::vec3 positions[],
+                                  const AtomList& atoms,
+                                  EdgeMap& edgeVertices, Brick& brick)
+{
+    const int N_SAMPLES = (BRICK_CELLS + 1) * (BRICK_CELLS + 1) * (BRICK_CELLS + 1);
+    int key = std::min(sampleA, sampleB) * N_SAMPLES + std::max(sampleA, sampleB);
+    auto existing = edgeVertices.find(key);
+    if (existing != edgeVertices.end())
+        return existing->second;
+
+    float t = (ISOVALUE - density[sampleA]) / (density[sampleB] - density[sampleA]);
+    auto position = glm::mix(positions[sampleA], positions[sampleB], t);
+
+    //density is far from linear between samples, so take one Newton step
+    //towards the true isosurface, on the log of the density since that is
+    //nearly quadratic around each atom, and no further than one sample
+    glm::vec3 gradient, color;
+    float value = evaluate(position, atoms, gradient, color);
+    float gradientLength2 = glm::dot(gradient, gradient);
+    if (value > 0 && gradientLength2 > 0)
+    {
+        auto step = gradient * (std::log(value / ISOVALUE) * value / gradientLength2);
+        float stepLength = glm::length(step);
+        if (stepLength > GRID_SPACING)
+            step *= GRID_SPACING / stepLength;
+
+        position -= step;
+        evaluate(position, atoms, gradient, color);
+    }
+
+    //density decreases outward, so the normal is opposite its gradient
+    float gradientLength = glm::length(gradient);
+    auto vertexIndex = (GLuint)brick.vertices.size();
+    brick.vertices.push_back(position);
+    brick.normals.push_back(gradientLength > 0 ?
+        -gradient / gradientLength : glm::vec3(0, 0, 1));
+    brick.colors.push_back(color);
+
+    edgeVertices[key] = vertexIndex;
+    return vertexIndex;
+}
+
+
+
+//returns the density at the position, along with its gradient and the
+//atoms' colors blended by how much each of them contributes
+float GaussianSurface::evaluate(const glm::vec3& position, const AtomList& atoms,
+                                glm::vec3& gradient, glm::vec3& color)
+{
+    gradient = color = glm::vec3(0);
+    float density = 0;
+    for (auto atom : atoms)
+    {
+        auto offset = position - positions_[atom];
+        float inverseRadius2 = 1 / (radii_[atom] * radii_[atom]);
+        float reach = radii_[atom] * REACH;
+        float distance2 = glm::dot(offset, offset);
+        if (distance2 >= reach * reach)
+            continue;
+
+        float weight = std::exp(BLOBBINESS * (distance2 * inverseRadius2 - 1));
+        gradient += offset * (weight * 2 * BLOBBINESS * inverseRadius2);
+        color += colors_[atom] * weight;
+        density += weight;
+    }
+
+    color = density > 0 ? color / density : glm::vec3(1);
+    return density;
+}
@@ -0,0 +1,106 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+#ifndef GAUSSIAN_SURFACE
+#define GAUSSIAN_SURFACE
+
+/**
+    A GaussianSurface builds a smooth molecular surface around a set of atoms.
+    Every atom contributes a Gaussian blob of density, scaled to its radius,
+    to a regular grid of samples, and the surface is the isosurface of that
+    density. The grid is split into bricks of cells that are meshed
+    independently on the ThreadPool. Each cell is cut into six tetrahedra and
+    triangulated by marching tetrahedra, which needs no case tables and has no
+    ambiguous cases. update() compares the new positions against the ones that
+    were last meshed and only re-meshes the bricks within reach of the atoms
+    that moved, so small changes between frames stay cheap. Normals and colors
+    are evaluated directly from the atoms' contributions at each vertex.
+**/
+
+#include "glm/glm.hpp"
+#include <GL/glew.h>
+#include <unordered_map>
+#include <vector>
+#include <memory>
+
+class GaussianSurface
+{
+    public:
+        const float GRID_SPACING = 1.0f;  //angstroms between samples
+        const int BRICK_CELLS = 8; //cells along each side of a brick
+        const float BLOBBINESS = -2.3f; //how tightly density hugs each atom
+        const float ISOVALUE = 1.0f; //the density on the surface
+        const float REACH = 2.0f; //radii past which density is ignored
+        const float MOVEMENT_TOLERANCE = 0.1f;  //smaller moves are ignored
+
+    public:
+        GaussianSurface(const std::vector<float>& radii,
+                        const std::vector<glm::vec3>& colors,
+                        const glm::vec3& minimum, const glm::vec3& maximum);
+        std::size_t update(const std::vector<glm::vec3>& positions);
+        void getMesh(std::vector<glm::vec3>& vertices,
+                     std::vector<glm::vec3>& normals,
+                     std::vector<glm::vec3>& colors,
+                     std::vector<GLuint>& indices);
+        std::size_t countBricks();
+        std::size_t countTriangles();
+
+    private:
+        struct Brick
+        {
+            std::vector<glm::vec3> vertices, normals, colors;
+            std::vector<GLuint> indices;
+        };
+
+        typedef std::vector<std::size_t> AtomList;
+        typedef std::unordered_map<int, GLuint> EdgeMap; //samples to vertex
+
+        void markBricks(const glm::vec3& position, float reach,
+                        std::vector<bool>& marks);
+        void getBrickRange(const glm::vec3& position, float reach,
+                           glm::ivec3& low, glm::ivec3& high);
+        void meshBrick(std::size_t brickIndex, const AtomList& atoms);
+        void addTetrahedron(const int corners[4], const float density[],
+                            const glm::vec3 positions[], const AtomList& atoms,
+                            EdgeMap& edgeVertices, Brick& brick);
+        GLuint addVertex(int sampleA, int sampleB, const float density[],
+                         const glm::vec3 positions[], const AtomList& atoms,
+                         EdgeMap& edgeVertices, Brick& brick);
+        float evaluate(const glm::vec3& position, const AtomList& atoms,
+                       glm::vec3& gradient, glm::vec3& color);
+
+    private:
+        std::vector<float> radii_;
+        std::vector<glm::vec3> colors_;
+        glm::vec3 origin_;
+        glm::ivec3 nBricks_;
+        std::vector<glm::vec3> positions_; //as of the last meshing
+        std::vector<Brick> bricks_;
+        std::vector<AtomList> brickAtoms_; //reused between updates
+};
+
+typedef std::shared_ptr<GaussianSurface> GaussianSurfacePtr;
+
+#endif
@@ -80,6 +80,16 @@ void Mesh::draw()
 
 
 
+void Mesh::drawInstanced(GLsizei instances)
+{
+    if (indexBuffer_)
+        indexBuffer_->drawInstanced(renderingMode_, instances);
+    else
+        vertexBuffer_->drawInstanced(renderingMode_, instances);
+}
+
+
+
 std::vector<glm::vec3> Mesh::getVertices()
 {
     return vertexBuffer_->getVertices();
@@ -102,6 +112,29 @@ std::vector<Triangle> Mesh::getTriangles()
 
 
 
+//how many triangles one draw() rasterizes, for the statistics
+std::size_t Mesh::countTriangles()
+{
+    std::size_t count = indexBuffer_ ? indexBuffer_->getIndexCount() :
+        vertexBuffer_->getVertexCount();
+
+    switch (renderingMode_)
+    {
+        case GL_TRIANGLES:
+            return count / 3;
+        case GL_TRIANGLE_STRIP:
+        case GL_TRIANGLE_FAN:
+        case GL_QUAD_STRIP:
+            return count > 2 ? count - 2 : 0;
+        case GL_QUADS:
+            return count / 4 * 2;
+        default: //points and lines
+            return 0;
+    }
+}
+
+
+
 std::shared_ptr<VertexBuffer> Mesh::getVertexBuffer()
 {
     return vertexBuffer_;
@@ -63,12 +63,14 @@ class Mesh : public DataBuffer
         virtual void enable();
         virtual void disable();
         virtual void draw();
+        virtual void drawInstanced(GLsizei instances);
 
         virtual SnippetPtr getVertexShaderGLSL();
         virtual SnippetPtr getFragmentShaderGLSL();
 
         std::vector<glm::vec3> getVertices();
         std::vector<Triangle> getTriangles();
+        std::size_t countTriangles();
 
         std::shared_ptr<VertexBuffer> getVertexBuffer();
         std::shared_ptr<IndexBuffer> getIndexBuffer();
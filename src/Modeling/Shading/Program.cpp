@@ -28,6 +28,13 @@
 #include <iostream>
 
 
+//for a Program that is loaded from a binary, rather than linked from shaders
+cs5400::Program::Program():
+    handle_(glCreateProgram())
+{}
+
+
+
 cs5400::Program::Program(
     const std::shared_ptr<VertexShader>& vertex,
     const std::shared_ptr<FragmentShader>& fragment):
@@ -51,9 +58,10 @@ GLuint cs5400::Program::getHandle()
 
 
 
+//a retrievable Program's binary can be saved in a ProgramCache
 std::shared_ptr<cs5400::Program> cs5400::makeProgram(
     const std::shared_ptr<VertexShader>& vertex,
-    const std::shared_ptr<FragmentShader>& fragment
+    const std::shared_ptr<FragmentShader>& fragment, bool retrievable
 )
 {
     auto program = std::make_shared<Program>(vertex, fragment);
@@ -61,6 +69,13 @@ std::shared_ptr<cs5400::Program> cs5400::makeProgram(
 
     glAttachShader(programHandle, vertex->getHandle());
     glAttachShader(programHandle, fragment->getHandle());
+
+    //generic attribute 0 must be per-vertex, since the per-instance attributes
+    //are constants when there is no hardware instancing
+    glBindAttribLocation(programHandle, 0, "vertex");
+    if (retrievable)
+        glProgramParameteri(programHandle, GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+            GL_TRUE);
     glLinkProgram (programHandle);
 
     GLint link_ok = GL_FALSE;
@@ -34,6 +34,7 @@ namespace cs5400
     class Program
     {
         public:
+            Program();
             Program(
                 const std::shared_ptr<VertexShader>& vertex,
                 const std::shared_ptr<FragmentShader>& fragment);
@@ -48,7 +49,8 @@ namespace cs5400
 
     std::shared_ptr<Program> makeProgram(
         const std::shared_ptr<VertexShader>& vertex,
-        const std::shared_ptr<FragmentShader>& fragment);
+        const std::shared_ptr<FragmentShader>& fragment,
+        bool retrievable = false);
 }
 
 void checkGlError();
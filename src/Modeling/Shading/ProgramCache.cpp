@@ -0,0 +1,213 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+#include "ProgramCache.hpp"
+#include <fstream>
+#include <sstream>
+#include <iterator>
+#include <iomanip>
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cerrno>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+ProgramCache::ProgramCache(const std::string& directory) :
+    directory_(directory)
+{
+    std::stringstream stream("");
+    stream << glGetString(GL_VENDOR) << "\n" << glGetString(GL_RENDERER) <<
+        "\n" << glGetString(GL_VERSION);
+    driver_ = stream.str();
+
+    writable_ = makeDirectories(directory_);
+    if (!writable_)
+        std::cerr << "Cannot create " << directory_ << ", shader programs " <<
+            "will not be cached." << std::endl;
+}
+
+
+
+//returns the cached Program for this source, or null if there is none. A file
+//that is truncated or that the driver rejects is removed, so that the binary
+//saved after compiling replaces it instead of being read again next launch
+ProgramPtr ProgramCache::load(const std::string& vertexCode,
+                              const std::string& fragmentCode)
+{
+    auto path = getPath(vertexCode, fragmentCode);
+    std::ifstream fin(path, std::ios::in | std::ios::binary);
+    if (!fin.good())
+        return nullptr;
+
+    GLenum format;
+    std::vector<char> binary;
+    if (fin.read((char*)&format, sizeof(format)))
+        binary.assign(std::istreambuf_iterator<char>(fin),
+                      std::istreambuf_iterator<char>());
+    fin.close();
+
+    if (binary.empty())
+    {
+        std::remove(path.c_str());
+        return nullptr;
+    }
+
+    auto program = std::make_shared<cs5400::Program>();
+    glProgramBinary(program->getHandle(), format, binary.data(),
+        (GLsizei)binary.size());
+
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program->getHandle(), GL_LINK_STATUS, &linked);
+    glGetError(); //an unknown format is an error, but only means a miss
+    if (linked == GL_FALSE)
+    {
+        std::remove(path.c_str());
+        return nullptr;
+    }
+
+    std::cout << "Loaded Program " << program->getHandle() <<
+        " from cached binary." << std::endl;
+    return program;
+}
+
+
+
+//the binary is written to a temporary file first, and then renamed, so that
+//another instance reading it never sees half of it. The temporary file is
+//named after this process, so two instances saving at once never share one
+void ProgramCache::save(const ProgramPtr& program,
+                        const std::string& vertexCode,
+                        const std::string& fragmentCode)
+{
+    if (!writable_)
+        return;
+
+    GLint length = 0;
+    glGetProgramiv(program->getHandle(), GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+
+    GLenum format;
+    GLsizei written = 0;
+    std::vector<char> binary((std::size_t)length);
+    glGetProgramBinary(program->getHandle(), length, &written, &format,
+        binary.data());
+    if (written <= 0)
+        return;
+
+    auto path = getPath(vertexCode, fragmentCode);
+    auto temporaryPath = path + "." + std::to_string(getpid()) + ".tmp";
+    {
+        std::ofstream fout(temporaryPath, std::ios::out | std::ios::binary);
+        fout.write((const char*)&format, sizeof(format));
+        fout.write(binary.data(), written);
+        if (!fout.good())
+        {
+            std::remove(temporaryPath.c_str());
+            return;
+        }
+    }
+
+    std::rename(temporaryPath.c_str(), path.c_str());
+}
+
+
+
+std::string ProgramCache::getDirectory()
+{
+    return directory_;
+}
+
+
+
+//a 64-bit FNV-1a hash, which unlike std::hash is the same in every build
+std::string ProgramCache::getPath(const std::string& vertexCode,
+                                  const std::string& fragmentCode)
+{
+    const std::string* parts[] = { &driver_, &vertexCode, &fragmentCode };
+
+    std::uint64_t hash = 14695981039346656037ULL;
+    for (const auto* part : parts)
+    {
+        for (unsigned char c : *part)
+            hash = (hash ^ c) * 1099511628211ULL;
+        hash = (hash ^ 0xFF) * 1099511628211ULL; //keeps the parts apart
+    }
+
+    std::stringstream stream("");
+    stream << directory_ << "/" << std::hex << std::setw(16) <<
+        std::setfill('0') << hash << ".bin";
+    return stream.str();
+}
+
+
+
+bool ProgramCache::isSupported()
+{
+    if (!GLEW_ARB_get_program_binary)
+        return false;
+
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    return formats > 0;
+}
+
+
+
+//$XDG_CACHE_HOME/folding-atomata, or ~/.cache/folding-atomata by default
+std::string ProgramCache::getDefaultDirectory()
+{
+    const char* cacheHome = std::getenv("XDG_CACHE_HOME");
+    if (cacheHome && *cacheHome)
+        return std::string(cacheHome) + "/folding-atomata";
+
+    const char* home = std::getenv("HOME");
+    if (home && *home)
+        return std::string(home) + "/.cache/folding-atomata";
+
+    return "";
+}
+
+
+
+//creates the directory and any missing parents, like mkdir -p
+bool ProgramCache::makeDirectories(const std::string& path)
+{
+    if (path.empty())
+        return false;
+
+    for (std::size_t slash = path.find('/', 1); ;
+         slash = path.find('/', slash + 1))
+    {
+        auto prefix = path.substr(0, slash);
+        if (mkdir(prefix.c_str(), 0755) != 0 && errno != EEXIST)
+            return false;
+        if (slash == std::string::npos)
+            return true;
+    }
+}
@@ -0,0 +1,67 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+#ifndef PROGRAM_CACHE
+#define PROGRAM_CACHE
+
+/**
+    A ProgramCache keeps the binaries of linked shader Programs on disk, so
+    that later launches can skip compiling and linking them. Each binary is
+    filed under a hash of the vertex and fragment source together with the
+    driver's vendor, renderer, and version, since a binary is only good for
+    the driver that made it. A binary the driver no longer accepts, such as
+    after an update that kept the same version string, is a miss like any
+    other, and the Program is compiled and its binary saved again.
+**/
+
+#include "Program.hpp"
+#include <string>
+#include <vector>
+
+class ProgramCache
+{
+    public:
+        ProgramCache(const std::string& directory);
+        ProgramPtr load(const std::string& vertexCode,
+                        const std::string& fragmentCode);
+        void save(const ProgramPtr& program, const std::string& vertexCode,
+                  const std::string& fragmentCode);
+        std::string getDirectory();
+
+        static bool isSupported();
+        static std::string getDefaultDirectory();
+
+    private:
+        std::string getPath(const std::string& vertexCode,
+                            const std::string& fragmentCode);
+        static bool makeDirectories(const std::string& path);
+
+    private:
+        std::string directory_;
+        std::string driver_; //vendor, renderer, and version
+        bool writable_;
+};
+
+#endif
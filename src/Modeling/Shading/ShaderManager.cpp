@@ -27,9 +27,15 @@
 #include "Program.hpp"
 #include <sstream>
 #include <thread>
+#include <chrono>
 #include <iostream>
 
 
+std::shared_ptr<ProgramCache> ShaderManager::cache_ = nullptr;
+std::size_t ShaderManager::programsCompiled_ = 0;
+std::size_t ShaderManager::programsLoaded_ = 0;
+float ShaderManager::buildTime_ = 0;
+
 ProgramPtr ShaderManager::createProgram(
     const std::shared_ptr<InstancedModel>& model, const SnippetPtr& sceneVertexShader,
     const SnippetPtr& sceneFragmentShader, const LightList& lights
@@ -45,10 +51,53 @@ ProgramPtr ShaderManager::createProgram(
                                               sceneFragmentShader, lights);
 
     std::cout << "done." << std::endl;
-    return cs5400::makeProgram(
-        cs5400::makeVertexShaderStr(vertexShaderStr),
-        cs5400::makeFragmentShaderStr(fragmentShaderStr)
-    );
+    return buildProgram(vertexShaderStr, fragmentShaderStr);
+}
+
+
+
+void ShaderManager::setProgramCache(const std::shared_ptr<ProgramCache>& cache)
+{
+    cache_ = cache;
+}
+
+
+
+void ShaderManager::reportBuildTime()
+{
+    std::cout << "Spent " << buildTime_ << " ms building " <<
+        programsCompiled_ + programsLoaded_ << " shader programs, " <<
+        programsLoaded_ << " of them from cached binaries." << std::endl;
+}
+
+
+
+//loads the Program from the cache if it can, otherwise compiles it
+ProgramPtr ShaderManager::buildProgram(const std::string& vertexShaderStr,
+                                       const std::string& fragmentShaderStr)
+{
+    using namespace std::chrono;
+    auto start = steady_clock::now();
+
+    auto program = cache_ ? cache_->load(vertexShaderStr, fragmentShaderStr) :
+        nullptr;
+    if (program)
+        programsLoaded_++;
+    else
+    {
+        program = cs5400::makeProgram(
+            cs5400::makeVertexShaderStr(vertexShaderStr),
+            cs5400::makeFragmentShaderStr(fragmentShaderStr),
+            cache_ != nullptr
+        );
+        if (cache_)
+            cache_->save(program, vertexShaderStr, fragmentShaderStr);
+        programsCompiled_++;
+    }
+
+    auto diff = duration_cast<microseconds>(steady_clock::now() - start).count();
+    buildTime_ += diff / 1000.0f;
+    return program;
 }
 
 
@@ -37,12 +37,15 @@
     The ShaderManager classes makes heavy use of typedefs to reduce the length
     of templatized types. Refer to Program.hpp, ShaderUtilizer.hpp, and
     /World/Light.hpp for full typedef declarations if they are not obvious.
+    Given a ProgramCache, Programs whose source was seen on an earlier launch
+    are loaded from their binaries instead of being compiled and linked.
 **/
 
 #include "Modeling/InstancedModel.hpp"
 #include "Modeling/DataBuffers/DataBuffer.hpp"
 #include "World/Light.hpp"
 #include "Program.hpp"
+#include "ProgramCache.hpp"
 #include <memory>
 #include <vector>
 #include <GL/glut.h>
@@ -53,8 +56,13 @@ class ShaderManager
         static ProgramPtr createProgram(const std::shared_ptr<InstancedModel>& obj,
             const SnippetPtr& sceneVertexShader,
             const SnippetPtr& sceneFragmentShader, const LightList& lights);
+        static void setProgramCache(const std::shared_ptr<ProgramCache>& cache);
+        static void reportBuildTime();
 
     private:
+        static ProgramPtr buildProgram(const std::string& vertexShaderStr,
+                                       const std::string& fragmentShaderStr);
+
         static std::vector<SnippetPtr> assembleVertexSnippets(
             const SnippetPtr& sceneVertexShader,
             const BufferList& buffers, const LightList& lights);
@@ -74,6 +82,11 @@ class ShaderManager
         static std::string assembleMainBodyCode(const SnippetList& snippets);
         static std::string buildShader(const std::string& fields,
             const std::string& methods, const std::string& mainBodyCode);
+
+    private:
+        static std::shared_ptr<ProgramCache> cache_; //optional
+        static std::size_t programsCompiled_, programsLoaded_;
+        static float buildTime_; //milliseconds, for both
 };
 
 #endif
@@ -0,0 +1,106 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+#include "SurfaceModel.hpp"
+#include "Modeling/GLStateCache.hpp"
+
+
+SurfaceModel::SurfaceModel(const GaussianSurfacePtr& surface,
+                           const std::vector<glm::vec3>& positions) :
+    SurfaceModel(surface, extractMesh(surface, positions))
+{}
+
+
+
+SurfaceModel::SurfaceModel(const GaussianSurfacePtr& surface,
+                           const MeshData& mesh) :
+    InstancedModel(std::make_shared<Mesh>(
+                       std::make_shared<VertexBuffer>(mesh.vertices),
+                       std::make_shared<IndexBuffer>(mesh.indices)),
+                   glm::mat4()),
+    surface_(surface), hasPendingMesh_(false)
+{
+    vertexBuffer_ = mesh_->getVertexBuffer();
+    indexBuffer_ = mesh_->getIndexBuffer();
+    normalBuffer_ = std::make_shared<NormalBuffer>(mesh.normals);
+    colorBuffer_ = std::make_shared<ColorBuffer>(mesh.colors);
+    optionalDBs_ = { colorBuffer_, normalBuffer_ };
+}
+
+
+
+void SurfaceModel::update(const std::vector<glm::vec3>& positions)
+{
+    if (surface_->update(positions) == 0)
+        return; //nothing moved far enough to change the surface
+
+    MeshData mesh;
+    surface_->getMesh(mesh.vertices, mesh.normals, mesh.colors, mesh.indices);
+
+    std::lock_guard<std::mutex> lock(pendingMutex_);
+    std::swap(pendingMesh_, mesh);
+    hasPendingMesh_ = true;
+}
+
+
+
+void SurfaceModel::render(GLuint programHandle)
+{
+    MeshData mesh;
+    bool hasMesh = false;
+
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex_);
+        if (hasPendingMesh_)
+        {
+            std::swap(pendingMesh_, mesh);
+            hasPendingMesh_ = false;
+            hasMesh = true;
+        }
+    }
+
+    if (hasMesh)
+    {   //binding the index buffer also sets it in the bound vertex array
+        if (vertexArray_)
+            GLStateCache::getInstance().bindVertexArray(vertexArray_);
+        vertexBuffer_->update(mesh.vertices);
+        normalBuffer_->update(mesh.normals);
+        colorBuffer_->update(mesh.colors);
+        indexBuffer_->update(mesh.indices);
+    }
+
+    InstancedModel::render(programHandle);
+}
+
+
+
+SurfaceModel::MeshData SurfaceModel::extractMesh(
+    const GaussianSurfacePtr& surface, const std::vector<glm::vec3>& positions)
+{
+    MeshData mesh;
+    surface->update(positions);
+    surface->getMesh(mesh.vertices, mesh.normals, mesh.colors, mesh.indices);
+    return mesh;
+}
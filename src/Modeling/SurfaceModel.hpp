@@ -0,0 +1,76 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+#ifndef SURFACE_MODEL
+#define SURFACE_MODEL
+
+/**
+    A SurfaceModel renders a GaussianSurface as a single InstancedModel, in
+    place of one sphere instance per atom. update() may be called from the
+    animation thread: it re-meshes the surface and, if anything changed, hands
+    the new mesh over to be uploaded. The upload itself has to happen on the
+    rendering thread, so it is applied at the start of the next render().
+**/
+
+#include "InstancedModel.hpp"
+#include "Mesh/GaussianSurface.hpp"
+#include "DataBuffers/ColorBuffer.hpp"
+#include "DataBuffers/NormalBuffer.hpp"
+#include <mutex>
+
+class SurfaceModel : public InstancedModel
+{
+    public:
+        SurfaceModel(const GaussianSurfacePtr& surface,
+                     const std::vector<glm::vec3>& positions);
+        void update(const std::vector<glm::vec3>& positions);
+        virtual void render(GLuint programHandle);
+
+    private:
+        struct MeshData
+        {
+            std::vector<glm::vec3> vertices, normals, colors;
+            std::vector<GLuint> indices;
+        };
+
+        SurfaceModel(const GaussianSurfacePtr& surface, const MeshData& mesh);
+        static MeshData extractMesh(const GaussianSurfacePtr& surface,
+                                    const std::vector<glm::vec3>& positions);
+
+    private:
+        GaussianSurfacePtr surface_;
+        std::shared_ptr<VertexBuffer> vertexBuffer_;
+        std::shared_ptr<IndexBuffer> indexBuffer_;
+        std::shared_ptr<NormalBuffer> normalBuffer_;
+        std::shared_ptr<ColorBuffer> colorBuffer_;
+
+        MeshData pendingMesh_;
+        bool hasPendingMesh_;
+        std::mutex pendingMutex_;
+};
+
+typedef std::shared_ptr<SurfaceModel> SurfaceModelPtr;
+
+#endif
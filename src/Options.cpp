@@ -64,20 +64,60 @@ bool Options::handleFlagsInternal(int argc, char** argv)
     TCLAP::SwitchArg cycleSnapshotsFlag("C", "cycle-snapshots",
         "If enabled, the animation runs backwards at end.", false);
 
+    TCLAP::ValueArg<float> decimateFlag("d", "decimate",
+        "Drops snapshots within this RMSD of the previous one.", false,
+        0, "angstroms");
+
+    TCLAP::SwitchArg gpuInterpolationFlag("g", "gpu-interpolation",
+        "Interpolates atom positions on the GPU, if it can.", false);
+
+    TCLAP::SwitchArg impostorsFlag("", "impostors",
+        "Ray-casts atoms and bonds instead of tessellating them.",
+        false);
+
     TCLAP::ValueArg<std::string> skyboxImageFlag("i", "image",
         "Specifies the path to image for the skybox.", false,
         "/usr/share/FoldingAtomata/images/gradient.png", "path");
 
+    TCLAP::ValueArg<unsigned int> keyframeCacheFlag("k", "keyframe-cache",
+        "Megabytes for caching each snapshot's bonds. Disabled by default.", false,
+        0, "megabytes");
+
     TCLAP::SwitchArg licenseFlag("l", "license",
         "Prints license information and exits.", false);
 
+    TCLAP::SwitchArg levelsOfDetailFlag("", "lod",
+        "Draws atoms and bonds coarser the smaller they appear on screen.",
+        false);
+
     TCLAP::ValueArg<unsigned int> modeFlag("m", "mode",
-        "Rendering mode. 3 is stick. Ball-n-stick by default.", false,
+        "Rendering mode. 3 is stick, 5 is surface. Ball-n-stick by default.", false,
         0, "milliseconds");
 
+    TCLAP::SwitchArg noCullingFlag("", "no-culling",
+        "Draws every atom and bond, even those outside the view.", false);
+
+    TCLAP::SwitchArg noInstancingFlag("", "no-instancing",
+        "Issues one draw call per atom and bond, as without hardware support.",
+        false);
+
+    TCLAP::SwitchArg noProgramCacheFlag("", "no-program-cache",
+        "Compiles every shader program, instead of loading cached binaries.",
+        false);
+
     TCLAP::SwitchArg noSkyboxFlag("n", "no-skybox",
         "Disables the skybox, leaving a black background.", false);
 
+    TCLAP::SwitchArg noUniformBuffersFlag("", "no-uniform-buffers",
+        "Sets the camera and lights in each shader program separately.", false);
+
+    TCLAP::SwitchArg noVertexArraysFlag("", "no-vertex-arrays",
+        "Enables every buffer on each draw, instead of using vertex array "
+        "objects.", false);
+
+    TCLAP::SwitchArg occlusionCullingFlag("", "occlusion-culling",
+        "Skips atoms and bonds hidden behind others.", false);
+
     TCLAP::SwitchArg oneSlotFlag("o", "one-slot",
         "Only shows one slot, instead of all available slots.", false);
 
@@ -85,6 +125,10 @@ bool Options::handleFlagsInternal(int argc, char** argv)
         "Password for accessing the remote FAHClient.", false,
         "", "string");
 
+    TCLAP::ValueArg<float> representativesFlag("r", "representatives",
+        "Only animate one snapshot per cluster within this RMSD.", false,
+        0, "angstroms");
+
     TCLAP::ValueArg<unsigned int> slicesFlag("s", "slices",
         "Slices to use for the atom mesh. Default is 8.", false,
         8, "unsigned int");
@@ -103,12 +147,24 @@ bool Options::handleFlagsInternal(int argc, char** argv)
     cmd.add(animationDelayFlag);
     cmd.add(connectFlag);
     cmd.add(cycleSnapshotsFlag);
+    cmd.add(decimateFlag);
+    cmd.add(gpuInterpolationFlag);
+    cmd.add(impostorsFlag);
     cmd.add(skyboxImageFlag);
+    cmd.add(keyframeCacheFlag);
     cmd.add(licenseFlag);
+    cmd.add(levelsOfDetailFlag);
     cmd.add(modeFlag);
+    cmd.add(noCullingFlag);
+    cmd.add(noInstancingFlag);
+    cmd.add(noProgramCacheFlag);
     cmd.add(noSkyboxFlag);
+    cmd.add(noUniformBuffersFlag);
+    cmd.add(noVertexArraysFlag);
+    cmd.add(occlusionCullingFlag);
     cmd.add(oneSlotFlag);
     cmd.add(passwordFlag);
+    cmd.add(representativesFlag);
     cmd.add(slicesFlag);
     cmd.add(stacksFlag);
     cmd.add(verboseFlag);
@@ -118,7 +174,12 @@ bool Options::handleFlagsInternal(int argc, char** argv)
     animationDelay_ = animationDelayFlag.getValue();
     connectionPath_ = connectFlag.getValue();
     cycleSnapshots_ = cycleSnapshotsFlag.isSet();
+    decimationThreshold_ = decimateFlag.getValue();
+    gpuInterpolation_ = gpuInterpolationFlag.isSet();
+    impostors_ = impostorsFlag.isSet();
     imagePath_ = skyboxImageFlag.getValue();
+    keyframeCacheSize_ = keyframeCacheFlag.getValue();
+    levelsOfDetail_ = levelsOfDetailFlag.isSet();
 
     if (licenseFlag.isSet())
     {
@@ -136,14 +197,24 @@ bool Options::handleFlagsInternal(int argc, char** argv)
             case 3:
                 renderMode_ = RenderMode::STICK;
                 break;
+            case 5:
+                renderMode_ = RenderMode::SURFACE;
+                break;
             default:
                 renderMode_ = RenderMode::BALL_N_STICK;
         }
     }
 
+    cullingDisabled_ = noCullingFlag.isSet();
+    instancingDisabled_ = noInstancingFlag.isSet();
+    programCacheDisabled_ = noProgramCacheFlag.isSet();
     skyboxDisabled_ = noSkyboxFlag.isSet();
+    uniformBuffersDisabled_ = noUniformBuffersFlag.isSet();
+    vertexArraysDisabled_ = noVertexArraysFlag.isSet();
     oneSlot_        = oneSlotFlag.isSet();
+    occlusionCulling_ = occlusionCullingFlag.isSet();
     authPassword_   = passwordFlag.getValue();
+    clusterCutoff_  = representativesFlag.getValue();
     atomSlices_     = slicesFlag.getValue();
     atomStacks_     = stacksFlag.getValue();
     highVerbosity_  = verboseFlag.isSet();
@@ -218,6 +289,49 @@ bool Options::cycleSnapshots()
 
 
 
+bool Options::interpolateOnGPU()
+{
+    return gpuInterpolation_;
+}
+
+
+
+bool Options::useImpostors()
+{
+    return impostors_;
+}
+
+
+
+bool Options::useLevelsOfDetail()
+{
+    return levelsOfDetail_;
+}
+
+
+
+float Options::getClusterCutoff()
+{
+    return clusterCutoff_;
+}
+
+
+
+float Options::getDecimationThreshold()
+{
+    return decimationThreshold_;
+}
+
+
+
+//in bytes
+std::size_t Options::getKeyframeCacheSize()
+{
+    return (std::size_t)keyframeCacheSize_ * 1024 * 1024;
+}
+
+
+
 bool Options::highVerbosity()
 {
     return highVerbosity_;
@@ -225,6 +339,48 @@ bool Options::highVerbosity()
 
 
 
+bool Options::cullingDisabled()
+{
+    return cullingDisabled_;
+}
+
+
+
+bool Options::useOcclusionCulling()
+{
+    return occlusionCulling_;
+}
+
+
+
+bool Options::instancingDisabled()
+{
+    return instancingDisabled_;
+}
+
+
+
+bool Options::programCacheDisabled()
+{
+    return programCacheDisabled_;
+}
+
+
+
+bool Options::uniformBuffersDisabled()
+{
+    return uniformBuffersDisabled_;
+}
+
+
+
+bool Options::vertexArraysDisabled()
+{
+    return vertexArraysDisabled_;
+}
+
+
+
 bool Options::skyboxDisabled()
 {
     return skyboxDisabled_;
@@ -40,7 +40,7 @@ class Options
 
         enum class RenderMode : short
         {
-            BALL_N_STICK, STICK
+            BALL_N_STICK, STICK, SURFACE
         };
 
         std::string getHost();
@@ -52,7 +52,19 @@ class Options
         unsigned int getAtomSlices();
         int getAnimationDelay();
         bool cycleSnapshots();
+        bool interpolateOnGPU();
+        bool useImpostors();
+        bool useLevelsOfDetail();
+        float getClusterCutoff();
+        float getDecimationThreshold();
+        std::size_t getKeyframeCacheSize();
         bool highVerbosity();
+        bool cullingDisabled();
+        bool instancingDisabled();
+        bool programCacheDisabled();
+        bool uniformBuffersDisabled();
+        bool vertexArraysDisabled();
+        bool useOcclusionCulling();
         bool skyboxDisabled();
         std::string getSkyboxPath();
         bool showOneSlot();
@@ -64,8 +76,14 @@ class Options
         static Options* singleton_;
 
         bool highVerbosity_, cycleSnapshots_, skyboxDisabled_, oneSlot_;
+        bool gpuInterpolation_, instancingDisabled_;
+        bool impostors_, levelsOfDetail_, cullingDisabled_, occlusionCulling_;
+        bool programCacheDisabled_, uniformBuffersDisabled_;
+        bool vertexArraysDisabled_;
         std::string connectionPath_, authPassword_, imagePath_;
         unsigned int atomStacks_, atomSlices_, animationDelay_;
+        unsigned int keyframeCacheSize_;
+        float clusterCutoff_, decimationThreshold_;
         RenderMode renderMode_ = RenderMode::BALL_N_STICK;
 };
 
@@ -116,10 +116,10 @@ AtomPtr TrajectoryParser::parseAtom(const Indexes& atomSpan)
     int number;
     float charge, radius, mass;
 
-    std::istringstream(tokens[1]) >> number;
-    std::istringstream(tokens[2]) >> charge;
-    std::istringstream(tokens[3]) >> radius;
-    std::istringstream(tokens[4]) >> mass;
+    std::istringstream(tokens[1]) >> charge;
+    std::istringstream(tokens[2]) >> radius;
+    std::istringstream(tokens[3]) >> mass;
+    std::istringstream(tokens[4]) >> number;
 
     return std::make_shared<Atom>(tokens[0], number, charge, radius, mass);
 }
@@ -0,0 +1,207 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <iostream>
+#include <typeinfo>
+
+
+ThreadPool* ThreadPool::singleton_ = 0;
+ThreadPool& ThreadPool::getInstance()
+{
+    if (!singleton_)
+    {
+        //the thread calling parallelFor helps out, so leave a core for it
+        std::size_t cores = std::thread::hardware_concurrency();
+        singleton_ = new ThreadPool(cores > 2 ? cores - 1 : 1);
+    }
+
+    return *singleton_;
+}
+
+
+
+ThreadPool::ThreadPool(std::size_t nWorkers) :
+    jobs_(nullptr), stopping_(false)
+{
+    workers_.reserve(nWorkers);
+    for (std::size_t j = 0; j < nWorkers; j++)
+        workers_.push_back(std::thread([this] { workLoop(); }));
+}
+
+
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+
+    wakeWorkers_.notify_all();
+    for (auto& worker : workers_)
+        worker.join();
+}
+
+
+
+void ThreadPool::enqueue(const std::function<void()>& task)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push_back(task);
+    }
+
+    wakeWorkers_.notify_one();
+}
+
+
+
+std::size_t ThreadPool::countWorkers()
+{
+    return workers_.size();
+}
+
+
+
+void ThreadPool::run(Job& job)
+{
+    if (job.count <= job.grainSize || workers_.empty())
+    { //not worth waking anybody up
+        job.invoke(job.body, 0, job.count);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        job.nextJob = jobs_;
+        jobs_ = &job;
+    }
+    wakeWorkers_.notify_all();
+
+    while (processChunk(job))
+        ;
+
+    //wait for the chunks still in flight, then unlink the job
+    std::unique_lock<std::mutex> lock(mutex_);
+    jobDone_.wait(lock, [&]
+    {
+        return job.completed == job.count && job.activeWorkers == 0;
+    });
+
+    Job** link = &jobs_;
+    while (*link != &job)
+        link = &(*link)->nextJob;
+    *link = job.nextJob;
+    lock.unlock();
+
+    if (job.error) //every chunk has finished, so report the first failure
+        std::rethrow_exception(job.error);
+}
+
+
+
+bool ThreadPool::processChunk(Job& job)
+{
+    std::size_t begin = job.next.fetch_add(job.grainSize);
+    if (begin >= job.count)
+        return false;
+
+    std::size_t end = std::min(begin + job.grainSize, job.count);
+    try
+    {
+        job.invoke(job.body, begin, end);
+    }
+    catch (...)
+    { //keep going so that the caller can still join
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!job.error)
+            job.error = std::current_exception();
+    }
+
+    job.completed += end - begin;
+    return true;
+}
+
+
+
+ThreadPool::Job* ThreadPool::findJob()
+{
+    for (Job* job = jobs_; job != nullptr; job = job->nextJob)
+        if (job->next < job->count)
+            return job;
+    return nullptr;
+}
+
+
+
+void ThreadPool::workLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true)
+    {
+        wakeWorkers_.wait(lock, [&]
+        {
+            return stopping_ || findJob() != nullptr || !tasks_.empty();
+        });
+
+        if (stopping_)
+            return;
+
+        //parallelFor callers are blocked, so they take priority over tasks
+        Job* job = findJob();
+        if (job)
+        {
+            job->activeWorkers++;
+            lock.unlock();
+
+            while (processChunk(*job))
+                ;
+
+            lock.lock();
+            job->activeWorkers--;
+            if (job->activeWorkers == 0)
+                jobDone_.notify_all();
+            continue;
+        }
+
+        auto task = tasks_.front();
+        tasks_.pop_front();
+        lock.unlock();
+
+        try
+        {
+            task();
+        }
+        catch (std::exception& e)
+        {
+            std::cerr << "Caught " << typeid(e).name() <<
+                " in background task: " << e.what() << std::endl;
+        }
+
+        lock.lock();
+    }
+}
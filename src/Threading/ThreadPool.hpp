@@ -0,0 +1,121 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+#ifndef THREAD_POOL
+#define THREAD_POOL
+
+/**
+    The ThreadPool owns a fixed set of persistent worker threads. It offers two
+    services: enqueue() runs a task in the background and returns immediately,
+    whereas parallelFor() splits the range [0, count) into chunks of at most
+    grainSize items, hands those chunks to the workers, and only returns once
+    every chunk is done. The calling thread also processes chunks while it
+    waits, so a parallelFor() issued from inside a worker can never deadlock.
+    parallelFor() does not allocate: the job lives on the caller's stack and
+    the body is invoked through a plain function pointer, which makes it safe
+    to use inside the frame loop. The body receives half-open ranges
+    (begin, end) so that it can batch its work. If a chunk throws, the
+    remaining chunks still run and the first exception is rethrown to the
+    caller once they are all done.
+**/
+
+#include <condition_variable>
+#include <functional>
+#include <exception>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <deque>
+#include <vector>
+
+class ThreadPool
+{
+    public:
+        static ThreadPool& getInstance();
+
+        ThreadPool(std::size_t nWorkers);
+        ~ThreadPool();
+
+        void enqueue(const std::function<void()>& task);
+        std::size_t countWorkers();
+
+        template <typename Body>
+        void parallelFor(std::size_t count, std::size_t grainSize,
+                         const Body& body);
+
+    private:
+        struct Job
+        {
+            void (*invoke)(const void* body, std::size_t begin, std::size_t end);
+            const void* body;
+            std::size_t count, grainSize;
+            std::atomic<std::size_t> next, completed;
+            std::size_t activeWorkers;
+            std::exception_ptr error; //first exception thrown by a chunk
+            Job* nextJob;
+        };
+
+        void run(Job& job);
+        bool processChunk(Job& job);
+        Job* findJob();
+        void workLoop();
+
+    private:
+        static ThreadPool* singleton_;
+
+        std::vector<std::thread> workers_;
+        std::deque<std::function<void()>> tasks_;
+        Job* jobs_; //intrusive list of the parallelFor calls in progress
+        std::mutex mutex_;
+        std::condition_variable wakeWorkers_, jobDone_;
+        bool stopping_;
+};
+
+
+
+template <typename Body>
+void ThreadPool::parallelFor(std::size_t count, std::size_t grainSize,
+                             const Body& body)
+{
+    if (count == 0)
+        return;
+
+    Job job;
+    job.invoke = [](const void* ptr, std::size_t begin, std::size_t end)
+    {
+        (*static_cast<const Body*>(ptr))(begin, end);
+    };
+    job.body = &body;
+    job.count = count;
+    job.grainSize = grainSize > 0 ? grainSize : 1;
+    job.next = 0;
+    job.completed = 0;
+    job.activeWorkers = 0;
+    job.nextJob = nullptr;
+
+    run(job);
+}
+
+#endif
@@ -0,0 +1,126 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+#include "Backbone.hpp"
+#include <iostream>
+
+typedef std::vector<std::vector<std::size_t>> AdjacencyList;
+
+
+namespace
+{
+    const std::size_t NONE = (std::size_t)-1;
+
+    std::size_t findNeighbor(const AdjacencyList& neighbors,
+                             const std::vector<std::string>& names,
+                             std::size_t atom, const std::string& name)
+    {
+        for (auto neighbor : neighbors[atom])
+            if (names[neighbor] == name)
+                return neighbor;
+        return NONE;
+    }
+
+
+
+    std::size_t findCarbonylOxygen(const AdjacencyList& neighbors,
+                                   const std::vector<std::string>& names,
+                                   std::size_t carbon)
+    {
+        auto oxygen = findNeighbor(neighbors, names, carbon, "O");
+        if (oxygen != NONE)
+            return oxygen;
+
+        //the C-terminus has OXT, OC1, or similar instead
+        for (auto neighbor : neighbors[carbon])
+            if (names[neighbor][0] == 'O')
+                return neighbor;
+        return NONE;
+    }
+}
+
+
+
+Backbone::Backbone(const TopologyPtr& topology)
+{
+    const auto ATOMS = topology->getAtoms();
+    const auto BONDS = topology->getBonds();
+
+    std::vector<std::string> names;
+    names.reserve(ATOMS.size());
+    for (auto atom : ATOMS)
+        names.push_back(atom->getSymbol());
+
+    AdjacencyList neighbors(ATOMS.size());
+    for (auto bond : BONDS)
+    {
+        if (bond.first >= ATOMS.size() || bond.second >= ATOMS.size())
+            continue;
+        neighbors[bond.first].push_back(bond.second);
+        neighbors[bond.second].push_back(bond.first);
+    }
+
+    for (std::size_t j = 0; j < ATOMS.size(); j++)
+    {
+        if (names[j] != "CA")
+            continue;
+
+        Residue residue;
+        residue.ca = j;
+        residue.n = findNeighbor(neighbors, names, j, "N");
+        residue.c = findNeighbor(neighbors, names, j, "C");
+        if (residue.n == NONE || residue.c == NONE)
+            continue; //not an amino acid
+
+        residue.o = findCarbonylOxygen(neighbors, names, residue.c);
+        if (residue.o == NONE)
+            continue;
+
+        residue.isProline =
+            findNeighbor(neighbors, names, residue.n, "CD") != NONE;
+        residue.linkedToPrevious = !residues_.empty() &&
+            findNeighbor(neighbors, names, residue.n, "C") ==
+                residues_.back().c;
+
+        residues_.push_back(residue);
+    }
+
+    std::cout << "Found " << residues_.size() << " residues in the backbone." <<
+        std::endl;
+}
+
+
+
+const std::vector<Backbone::Residue>& Backbone::getResidues() const
+{
+    return residues_;
+}
+
+
+
+std::size_t Backbone::countResidues() const
+{
+    return residues_.size();
+}
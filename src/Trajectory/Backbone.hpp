@@ -0,0 +1,62 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+#ifndef BACKBONE
+#define BACKBONE
+
+/**
+    FAHClient does not send residue records, only atom names such as "N",
+    "CA", "C", and "O" and the bonds between atoms. The Backbone class
+    recovers the amino acid residues from that: every alpha carbon "CA"
+    bonded to an "N" and a "C" starts a residue, and the carbonyl oxygen is
+    the oxygen bonded to that "C". Residues are ordered by their alpha
+    carbon's position in the atom list, which follows the chain. A residue is
+    linked to the previous one when that residue's C is bonded to its N,
+    so chain breaks and separate chains are detected from the topology too.
+**/
+
+#include "Topology.hpp"
+#include <vector>
+
+class Backbone
+{
+    public:
+        struct Residue
+        {
+            std::size_t n, ca, c, o; //atom indexes
+            bool linkedToPrevious; //peptide bond to the previous residue
+            bool isProline; //its N has no hydrogen, so it can't donate
+        };
+
+    public:
+        Backbone(const TopologyPtr& topology);
+        const std::vector<Residue>& getResidues() const;
+        std::size_t countResidues() const;
+
+    private:
+        std::vector<Residue> residues_;
+};
+
+#endif
@@ -0,0 +1,106 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+#include "CompressedBitset.hpp"
+#include <algorithm>
+
+
+CompressedBitset::CompressedBitset(std::size_t size,
+                                   const std::vector<std::size_t>& setBits) :
+    size_(size), count_(0)
+{
+    for (auto bit : setBits)
+    {
+        auto wordIndex = (std::uint32_t)(bit / 64);
+        if (wordIndexes_.empty() || wordIndexes_.back() != wordIndex)
+        {
+            wordIndexes_.push_back(wordIndex);
+            words_.push_back(0);
+        }
+
+        auto mask = (std::uint64_t)1 << (bit % 64);
+        if ((words_.back() & mask) == 0)
+            count_++;
+        words_.back() |= mask;
+    }
+
+    wordIndexes_.shrink_to_fit();
+    words_.shrink_to_fit();
+}
+
+
+
+bool CompressedBitset::test(std::size_t bit) const
+{
+    auto wordIndex = (std::uint32_t)(bit / 64);
+    auto found = std::lower_bound(wordIndexes_.begin(), wordIndexes_.end(),
+                                  wordIndex);
+    if (found == wordIndexes_.end() || *found != wordIndex)
+        return false;
+
+    auto word = words_[(std::size_t)(found - wordIndexes_.begin())];
+    return (word >> (bit % 64)) & 1;
+}
+
+
+
+std::size_t CompressedBitset::count() const
+{
+    return count_;
+}
+
+
+
+std::size_t CompressedBitset::countCommon(const CompressedBitset& other) const
+{
+    std::size_t common = 0, a = 0, b = 0;
+    while (a < wordIndexes_.size() && b < other.wordIndexes_.size())
+    {
+        if (wordIndexes_[a] < other.wordIndexes_[b])
+            a++;
+        else if (wordIndexes_[a] > other.wordIndexes_[b])
+            b++;
+        else
+            common += (std::size_t)__builtin_popcountll(words_[a++] &
+                                                        other.words_[b++]);
+    }
+
+    return common;
+}
+
+
+
+std::size_t CompressedBitset::size() const
+{
+    return size_;
+}
+
+
+
+std::size_t CompressedBitset::getMemoryUsage() const
+{
+    return sizeof(*this) + wordIndexes_.capacity() * sizeof(std::uint32_t) +
+                           words_.capacity() * sizeof(std::uint64_t);
+}
@@ -0,0 +1,63 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+#ifndef COMPRESSED_BITSET
+#define COMPRESSED_BITSET
+
+/**
+    A CompressedBitset is an immutable set of bits that only stores the 64-bit
+    words that have at least one bit set, along with the position of each of
+    those words. Contact maps are very sparse (a residue touches a handful of
+    others out of hundreds) and their set bits cluster near the diagonal, so
+    this typically shrinks them by one to two orders of magnitude compared
+    to a plain bitset, while test() stays a binary search and intersections
+    are a linear merge over popcounts.
+**/
+
+#include <vector>
+#include <cstdint>
+#include <memory>
+
+class CompressedBitset
+{
+    public:
+        //setBits must be sorted in ascending order and less than size
+        CompressedBitset(std::size_t size, const std::vector<std::size_t>& setBits);
+
+        bool test(std::size_t bit) const;
+        std::size_t count() const;
+        std::size_t countCommon(const CompressedBitset& other) const;
+        std::size_t size() const;
+        std::size_t getMemoryUsage() const;
+
+    private:
+        std::size_t size_, count_;
+        std::vector<std::uint32_t> wordIndexes_;
+        std::vector<std::uint64_t> words_;
+};
+
+typedef std::shared_ptr<const CompressedBitset> BitsetPtr;
+
+#endif
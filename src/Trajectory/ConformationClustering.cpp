@@ -0,0 +1,169 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+#include "ConformationClustering.hpp"
+#include "RMSD.hpp"
+#include "Threading/ThreadPool.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <iostream>
+
+
+ConformationClustering::ConformationClustering(const TrajectoryPtr& trajectory,
+                                               float cutoff) :
+    nSnapshots_((std::size_t)trajectory->countSnapshots())
+{
+    calculateMatrix(trajectory);
+    cluster(cutoff);
+
+    std::cout << "Grouped " << nSnapshots_ << " snapshots into " <<
+        clusters_.size() << " clusters within " << cutoff << " A RMSD" <<
+        std::endl;
+}
+
+
+
+const std::vector<ConformationClustering::Cluster>&
+    ConformationClustering::getClusters()
+{
+    return clusters_;
+}
+
+
+
+//the cluster centers, in simulation order
+std::vector<int> ConformationClustering::getRepresentatives()
+{
+    std::vector<int> representatives;
+    for (const auto& cluster : clusters_)
+        representatives.push_back(cluster.center);
+    std::sort(representatives.begin(), representatives.end());
+    return representatives;
+}
+
+
+
+float ConformationClustering::getRMSD(int snapshotA, int snapshotB)
+{
+    if (snapshotA < 0 || snapshotB < 0 ||
+        (std::size_t)snapshotA >= nSnapshots_ ||
+        (std::size_t)snapshotB >= nSnapshots_)
+        throw std::runtime_error("Snapshot index out of range!");
+    return matrix_[(std::size_t)snapshotA * nSnapshots_ + (std::size_t)snapshotB];
+}
+
+
+
+std::size_t ConformationClustering::countSnapshots()
+{
+    return nSnapshots_;
+}
+
+
+
+void ConformationClustering::calculateMatrix(const TrajectoryPtr& trajectory)
+{
+    auto atoms = RMSD::selectAtoms(trajectory->getTopology());
+    std::vector<RMSD::Coordinates> coordinates(nSnapshots_);
+    ThreadPool::getInstance().parallelFor(nSnapshots_, 1,
+        [&](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t j = begin; j < end; j++)
+                coordinates[j] = RMSD::prepare(trajectory->getSnapshot((int)j),
+                                               atoms);
+        }
+    );
+
+    //tiles on or above the diagonal, each a block of rows and columns
+    std::vector<std::pair<std::size_t, std::size_t>> tiles;
+    for (std::size_t row = 0; row < nSnapshots_; row += TILE_SIZE)
+        for (std::size_t col = row; col < nSnapshots_; col += TILE_SIZE)
+            tiles.push_back(std::make_pair(row, col));
+
+    matrix_.assign(nSnapshots_ * nSnapshots_, 0);
+    ThreadPool::getInstance().parallelFor(tiles.size(), 1,
+        [&](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t t = begin; t < end; t++)
+            {
+                auto rowEnd = std::min(tiles[t].first + TILE_SIZE, nSnapshots_);
+                auto colEnd = std::min(tiles[t].second + TILE_SIZE, nSnapshots_);
+                for (auto a = tiles[t].first; a < rowEnd; a++)
+                {
+                    for (auto b = std::max(a + 1, tiles[t].second); b < colEnd; b++)
+                    {
+                        auto rmsd = RMSD::calculate(coordinates[a], coordinates[b]);
+                        matrix_[a * nSnapshots_ + b] = rmsd;
+                        matrix_[b * nSnapshots_ + a] = rmsd;
+                    }
+                }
+            }
+        }
+    );
+}
+
+
+
+//the GROMOS clustering algorithm, Daura et al. (1999)
+void ConformationClustering::cluster(float cutoff)
+{
+    std::vector<bool> assigned(nSnapshots_, false);
+    std::size_t nRemaining = nSnapshots_;
+
+    while (nRemaining > 0)
+    {
+        std::size_t bestCenter = 0, bestCount = 0;
+        for (std::size_t a = 0; a < nSnapshots_; a++)
+        {
+            if (assigned[a])
+                continue;
+
+            std::size_t count = 0;
+            for (std::size_t b = 0; b < nSnapshots_; b++)
+                if (!assigned[b] && matrix_[a * nSnapshots_ + b] <= cutoff)
+                    count++;
+
+            if (count > bestCount)
+            {
+                bestCenter = a;
+                bestCount = count;
+            }
+        }
+
+        Cluster cluster;
+        cluster.center = (int)bestCenter;
+        for (std::size_t b = 0; b < nSnapshots_; b++)
+        {
+            if (!assigned[b] && matrix_[bestCenter * nSnapshots_ + b] <= cutoff)
+            {
+                assigned[b] = true;
+                cluster.members.push_back((int)b);
+            }
+        }
+
+        nRemaining -= cluster.members.size();
+        clusters_.push_back(cluster);
+    }
+}
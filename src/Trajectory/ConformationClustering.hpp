@@ -0,0 +1,75 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+#ifndef CONFORMATION_CLUSTERING
+#define CONFORMATION_CLUSTERING
+
+/**
+    ConformationClustering groups the snapshots of a Trajectory into clusters
+    of similar shape. It first fills the full snapshot-by-snapshot RMSD matrix,
+    comparing alpha carbons (or every atom when no protein backbone is found),
+    by splitting the upper triangle into square tiles that are spread over the
+    ThreadPool, so that each worker reuses the same few rows of coordinates.
+    The matrix is then clustered with the GROMOS algorithm: the snapshot with
+    the most neighbors within the cutoff becomes the center of a cluster, it
+    and its neighbors are removed, and this repeats until nothing is left.
+    The cluster centers, in the order they were simulated, give a playback
+    order that skips over near-duplicate conformations.
+**/
+
+#include "Trajectory.hpp"
+#include <vector>
+
+class ConformationClustering
+{
+    public:
+        struct Cluster
+        {
+            int center;
+            std::vector<int> members;
+        };
+
+        const std::size_t TILE_SIZE = 16;
+
+    public:
+        ConformationClustering(const TrajectoryPtr& trajectory, float cutoff);
+        const std::vector<Cluster>& getClusters();
+        std::vector<int> getRepresentatives();
+        float getRMSD(int snapshotA, int snapshotB);
+        std::size_t countSnapshots();
+
+    private:
+        void calculateMatrix(const TrajectoryPtr& trajectory);
+        void cluster(float cutoff);
+
+    private:
+        std::size_t nSnapshots_;
+        std::vector<float> matrix_; //nSnapshots_ x nSnapshots_, symmetric
+        std::vector<Cluster> clusters_;
+};
+
+typedef std::shared_ptr<ConformationClustering> ConformationClusteringPtr;
+
+#endif
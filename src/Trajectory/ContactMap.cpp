@@ -0,0 +1,186 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+#include "ContactMap.hpp"
+#include "Backbone.hpp"
+#include "SpatialGrid.hpp"
+#include "Threading/ThreadPool.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <iostream>
+
+
+ContactMap::ContactMap(const TrajectoryPtr& trajectory, Resolution resolution,
+                       float cutoff) :
+    trajectory_(trajectory), resolution_(resolution), cutoff_(cutoff)
+{
+    if (resolution_ == Resolution::RESIDUES)
+    {
+        Backbone backbone(trajectory_->getTopology());
+        for (const auto& residue : backbone.getResidues())
+            elements_.push_back(residue.ca);
+    }
+    else
+    {
+        auto nAtoms = trajectory_->getTopology()->getAtoms().size();
+        for (std::size_t j = 0; j < nAtoms; j++)
+            elements_.push_back(j);
+    }
+}
+
+
+
+//builds the maps of the snapshots appended since the last call, and returns
+//how many there were
+std::size_t ContactMap::update()
+{
+    auto first = maps_.size();
+    auto last = (std::size_t)trajectory_->countSnapshots();
+    if (first >= last)
+        return 0;
+
+    maps_.resize(last);
+    ThreadPool::getInstance().parallelFor(last - first, 1,
+        [&](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t j = first + begin; j < first + end; j++)
+                maps_[j] = calculateMap((int)j);
+        }
+    );
+    return last - first;
+}
+
+
+
+void ContactMap::calculateAll()
+{
+    update();
+}
+
+
+
+std::size_t ContactMap::countMaps()
+{
+    return maps_.size();
+}
+
+
+
+std::size_t ContactMap::countElements()
+{
+    return elements_.size();
+}
+
+
+
+BitsetPtr ContactMap::getMap(int snapshotIndex)
+{
+    if (snapshotIndex < 0 || (std::size_t)snapshotIndex >= maps_.size())
+        throw std::runtime_error("No contact map for that snapshot!");
+    return maps_[(std::size_t)snapshotIndex];
+}
+
+
+
+bool ContactMap::areInContact(int snapshotIndex, std::size_t a, std::size_t b)
+{
+    if (a == b || a >= elements_.size() || b >= elements_.size())
+        return false;
+    return getMap(snapshotIndex)->test(getPairIndex(std::min(a, b),
+                                                    std::max(a, b)));
+}
+
+
+
+float ContactMap::getNativeContactFraction(int snapshotIndex)
+{
+    auto map = getMap(snapshotIndex);
+    auto native = getMap((int)countMaps() - 1);
+    if (native->count() == 0)
+        return 0;
+    return map->countCommon(*native) / (float)native->count();
+}
+
+
+
+std::size_t ContactMap::getMemoryUsage()
+{
+    std::size_t bytes = 0;
+    for (auto map : maps_)
+        bytes += map->getMemoryUsage();
+    return bytes;
+}
+
+
+
+BitsetPtr ContactMap::calculateMap(int snapshotIndex)
+{
+    auto snapshot = trajectory_->getSnapshot(snapshotIndex);
+
+    std::vector<glm::vec3> positions;
+    positions.reserve(elements_.size());
+    for (auto atom : elements_)
+        positions.push_back(snapshot->getPosition(atom));
+
+    std::size_t minSeparation = 1;
+    if (resolution_ == Resolution::RESIDUES)
+        minSeparation = MIN_RESIDUE_SEPARATION;
+
+    SpatialGrid grid(positions, cutoff_);
+    const float CUTOFF_SQUARED = cutoff_ * cutoff_;
+
+    //rows are visited in order and sorted, so pair indexes come out sorted
+    std::vector<std::size_t> contacts, row;
+    for (std::size_t a = 0; a < positions.size(); a++)
+    {
+        row.clear();
+        grid.forEachNear(positions[a], [&](std::size_t b)
+        {
+            if (b < a + minSeparation)
+                return;
+
+            auto delta = positions[b] - positions[a];
+            if (glm::dot(delta, delta) < CUTOFF_SQUARED)
+                row.push_back(b);
+        });
+
+        std::sort(row.begin(), row.end());
+        for (auto b : row)
+            contacts.push_back(getPairIndex(a, b));
+    }
+
+    auto n = elements_.size();
+    auto nPairs = n > 1 ? n * (n - 1) / 2 : 0;
+    return std::make_shared<CompressedBitset>(nPairs, contacts);
+}
+
+
+
+//index of the pair (a, b), a < b, in the row-major upper triangle
+std::size_t ContactMap::getPairIndex(std::size_t a, std::size_t b)
+{
+    auto n = elements_.size();
+    return a * n - a * (a + 1) / 2 + (b - a - 1);
+}
@@ -0,0 +1,83 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+#ifndef CONTACT_MAP
+#define CONTACT_MAP
+
+/**
+    A ContactMap records, for every snapshot, which pairs of residues (or of
+    atoms) are closer than a cutoff. Residues are represented by their alpha
+    carbons, and residues less than three apart along the chain are ignored
+    since they always touch. Candidate pairs come from a SpatialGrid, and each
+    map is stored as a CompressedBitset over the upper triangle of the pair
+    matrix. update() only processes the snapshots that were appended since its
+    last call, spreading them over the ThreadPool, so the maps can be kept
+    current as FAHClient sends new checkpoints; calculateAll() is the same
+    for a new ContactMap. Neither may run while the maps are being read. The
+    fraction of the final snapshot's contacts present in a snapshot (the Q
+    value) gives a quick measure of how far along the fold is.
+**/
+
+#include "Trajectory.hpp"
+#include "CompressedBitset.hpp"
+
+class ContactMap
+{
+    public:
+        enum class Resolution : short
+        {
+            RESIDUES, ATOMS
+        };
+
+        const std::size_t MIN_RESIDUE_SEPARATION = 3;
+
+    public:
+        ContactMap(const TrajectoryPtr& trajectory, Resolution resolution,
+                   float cutoff);
+        std::size_t update();
+        void calculateAll();
+
+        std::size_t countMaps();
+        std::size_t countElements();
+        BitsetPtr getMap(int snapshotIndex);
+        bool areInContact(int snapshotIndex, std::size_t a, std::size_t b);
+        float getNativeContactFraction(int snapshotIndex);
+        std::size_t getMemoryUsage();
+
+    private:
+        BitsetPtr calculateMap(int snapshotIndex);
+        std::size_t getPairIndex(std::size_t a, std::size_t b);
+
+    private:
+        TrajectoryPtr trajectory_;
+        Resolution resolution_;
+        float cutoff_;
+        std::vector<std::size_t> elements_; //the atoms that are compared
+        std::vector<BitsetPtr> maps_;
+};
+
+typedef std::shared_ptr<ContactMap> ContactMapPtr;
+
+#endif
@@ -0,0 +1,213 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+#include "RMSD.hpp"
+#include "Backbone.hpp"
+#include <stdexcept>
+#include <cfloat>
+#include <cmath>
+
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+
+//alpha carbons, or every atom if there is no protein backbone
+std::vector<std::size_t> RMSD::selectAtoms(const TopologyPtr& topology)
+{
+    std::vector<std::size_t> atoms;
+    Backbone backbone(topology);
+    for (const auto& residue : backbone.getResidues())
+        atoms.push_back(residue.ca);
+
+    if (atoms.empty())
+        for (std::size_t j = 0; j < topology->getAtoms().size(); j++)
+            atoms.push_back(j);
+
+    return atoms;
+}
+
+
+
+RMSD::Coordinates RMSD::prepare(const SnapshotPtr& snapshot,
+                                const std::vector<std::size_t>& atoms)
+{
+    Coordinates coords;
+    coords.count = atoms.size();
+
+    glm::dvec3 centroid(0);
+    for (auto atom : atoms)
+        centroid += glm::dvec3(snapshot->getPosition(atom));
+    if (!atoms.empty())
+        centroid /= (double)atoms.size();
+
+    auto paddedSize = (atoms.size() + 3) / 4 * 4;
+    coords.x.assign(paddedSize, 0);
+    coords.y.assign(paddedSize, 0);
+    coords.z.assign(paddedSize, 0);
+    coords.selfProduct = 0;
+
+    for (std::size_t j = 0; j < atoms.size(); j++)
+    {
+        auto position = glm::dvec3(snapshot->getPosition(atoms[j])) - centroid;
+        coords.x[j] = (float)position.x;
+        coords.y[j] = (float)position.y;
+        coords.z[j] = (float)position.z;
+        coords.selfProduct += glm::dot(position, position);
+    }
+
+    return coords;
+}
+
+
+
+float RMSD::calculate(const Coordinates& a, const Coordinates& b)
+{
+    if (a.count != b.count)
+        throw std::runtime_error("Cannot compare conformations of different sizes!");
+    if (a.count == 0)
+        return 0;
+
+    double matrix[9];
+    accumulate(a, b, matrix);
+
+    double e0 = (a.selfProduct + b.selfProduct) / 2;
+    double largestEigenvalue = solveQCP(matrix, e0);
+    return (float)std::sqrt(std::fabs(2 * (e0 - largestEigenvalue) / (double)a.count));
+}
+
+
+
+//matrix = sum over atoms of a * b^T, in row-major order
+void RMSD::accumulate(const Coordinates& a, const Coordinates& b,
+                      double matrix[9])
+{
+#ifdef __SSE__
+    __m128 sums[9];
+    for (auto& sum : sums)
+        sum = _mm_setzero_ps();
+
+    for (std::size_t j = 0; j < a.x.size(); j += 4)
+    {
+        __m128 ax = _mm_loadu_ps(&a.x[j]);
+        __m128 ay = _mm_loadu_ps(&a.y[j]);
+        __m128 az = _mm_loadu_ps(&a.z[j]);
+        __m128 bx = _mm_loadu_ps(&b.x[j]);
+        __m128 by = _mm_loadu_ps(&b.y[j]);
+        __m128 bz = _mm_loadu_ps(&b.z[j]);
+
+        sums[0] = _mm_add_ps(sums[0], _mm_mul_ps(ax, bx));
+        sums[1] = _mm_add_ps(sums[1], _mm_mul_ps(ax, by));
+        sums[2] = _mm_add_ps(sums[2], _mm_mul_ps(ax, bz));
+        sums[3] = _mm_add_ps(sums[3], _mm_mul_ps(ay, bx));
+        sums[4] = _mm_add_ps(sums[4], _mm_mul_ps(ay, by));
+        sums[5] = _mm_add_ps(sums[5], _mm_mul_ps(ay, bz));
+        sums[6] = _mm_add_ps(sums[6], _mm_mul_ps(az, bx));
+        sums[7] = _mm_add_ps(sums[7], _mm_mul_ps(az, by));
+        sums[8] = _mm_add_ps(sums[8], _mm_mul_ps(az, bz));
+    }
+
+    for (int k = 0; k < 9; k++)
+    {
+        float lanes[4];
+        _mm_storeu_ps(lanes, sums[k]);
+        matrix[k] = (double)lanes[0] + (double)lanes[1] +
+                    (double)lanes[2] + (double)lanes[3];
+    }
+#else
+    for (int k = 0; k < 9; k++)
+        matrix[k] = 0;
+
+    for (std::size_t j = 0; j < a.count; j++)
+    {
+        const float A[3] = { a.x[j], a.y[j], a.z[j] };
+        const float B[3] = { b.x[j], b.y[j], b.z[j] };
+        for (int row = 0; row < 3; row++)
+            for (int col = 0; col < 3; col++)
+                matrix[row * 3 + col] += (double)(A[row] * B[col]);
+    }
+#endif
+}
+
+
+
+//returns the largest eigenvalue of the 4x4 key matrix, see Theobald (2005)
+//and Liu, Agrafiotis, & Theobald (2010) for the derivation
+double RMSD::solveQCP(const double matrix[9], double e0)
+{
+    double Sxx = matrix[0], Sxy = matrix[1], Sxz = matrix[2];
+    double Syx = matrix[3], Syy = matrix[4], Syz = matrix[5];
+    double Szx = matrix[6], Szy = matrix[7], Szz = matrix[8];
+
+    double Sxx2 = Sxx * Sxx, Syy2 = Syy * Syy, Szz2 = Szz * Szz;
+    double Sxy2 = Sxy * Sxy, Syz2 = Syz * Syz, Sxz2 = Sxz * Sxz;
+    double Syx2 = Syx * Syx, Szy2 = Szy * Szy, Szx2 = Szx * Szx;
+
+    double SyzSzymSyySzz2 = 2 * (Syz * Szy - Syy * Szz);
+    double Sxx2Syy2Szz2Syz2Szy2 = Syy2 + Szz2 - Sxx2 + Syz2 + Szy2;
+
+    double c2 = -2 * (Sxx2 + Syy2 + Szz2 + Sxy2 + Syx2 + Sxz2 + Szx2 +
+                      Syz2 + Szy2);
+    double c1 = 8 * (Sxx * Syz * Szy + Syy * Szx * Sxz + Szz * Sxy * Syx -
+                     Sxx * Syy * Szz - Syz * Szx * Sxy - Szy * Syx * Sxz);
+
+    double SxzpSzx = Sxz + Szx, SyzpSzy = Syz + Szy, SxypSyx = Sxy + Syx;
+    double SyzmSzy = Syz - Szy, SxzmSzx = Sxz - Szx, SxymSyx = Sxy - Syx;
+    double SxxpSyy = Sxx + Syy, SxxmSyy = Sxx - Syy;
+    double Sxy2Sxz2Syx2Szx2 = Sxy2 + Sxz2 - Syx2 - Szx2;
+
+    double c0 = Sxy2Sxz2Syx2Szx2 * Sxy2Sxz2Syx2Szx2 +
+        (Sxx2Syy2Szz2Syz2Szy2 + SyzSzymSyySzz2) *
+        (Sxx2Syy2Szz2Syz2Szy2 - SyzSzymSyySzz2) +
+        (-SxzpSzx * SyzmSzy + SxymSyx * (SxxmSyy - Szz)) *
+        (-SxzmSzx * SyzpSzy + SxymSyx * (SxxmSyy + Szz)) +
+        (-SxzpSzx * SyzpSzy - SxypSyx * (SxxpSyy - Szz)) *
+        (-SxzmSzx * SyzmSzy - SxypSyx * (SxxpSyy + Szz)) +
+        (SxypSyx * SyzpSzy + SxzpSzx * (SxxmSyy + Szz)) *
+        (-SxymSyx * SyzmSzy + SxzpSzx * (SxxpSyy + Szz)) +
+        (SxypSyx * SyzmSzy + SxzmSzx * (SxxmSyy - Szz)) *
+        (-SxymSyx * SyzpSzy + SxzmSzx * (SxxpSyy - Szz));
+
+    //Newton-Raphson, starting from e0, which bounds the root from above
+    const double PRECISION = 1e-11;
+    double eigenvalue = e0;
+    for (int j = 0; j < 50; j++)
+    {
+        double previous = eigenvalue;
+        double x2 = eigenvalue * eigenvalue;
+        double b = (x2 + c2) * eigenvalue;
+        double a = b + c1;
+        double numerator = a * eigenvalue + c0;
+        double denominator = 2 * x2 * eigenvalue + b + a;
+        if (std::fabs(denominator) <= DBL_EPSILON * std::fabs(numerator))
+            break; //the step would be too large to trust, or undefined
+
+        eigenvalue -= numerator / denominator;
+        if (std::fabs(eigenvalue - previous) < std::fabs(PRECISION * eigenvalue))
+            break;
+    }
+
+    return eigenvalue;
+}
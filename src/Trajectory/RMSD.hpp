@@ -0,0 +1,67 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+#ifndef RMSD_KERNEL
+#define RMSD_KERNEL
+
+/**
+    Computes the root-mean-square deviation between two conformations after
+    optimally superimposing them, using the quaternion characteristic
+    polynomial (QCP) method of Theobald (2005). Coordinates are first
+    prepared once per snapshot: centered on their centroid and laid out as
+    separate x, y, and z arrays padded to a multiple of four. The expensive
+    part, accumulating the 3x3 inner product matrix over all atoms, then runs
+    four atoms at a time with SSE (or a scalar fallback), and the
+    superposition itself only needs a few Newton-Raphson steps on a quartic,
+    with no rotation matrix ever being built.
+**/
+
+#include "Snapshot.hpp"
+#include "Topology.hpp"
+#include <vector>
+
+class RMSD
+{
+    public:
+        struct Coordinates
+        {
+            std::vector<float> x, y, z; //centered, padded with zeros
+            std::size_t count; //number of real atoms
+            double selfProduct; //sum of squared distances to the centroid
+        };
+
+    public:
+        static std::vector<std::size_t> selectAtoms(const TopologyPtr& topology);
+        static Coordinates prepare(const SnapshotPtr& snapshot,
+                                   const std::vector<std::size_t>& atoms);
+        static float calculate(const Coordinates& a, const Coordinates& b);
+
+    private:
+        static void accumulate(const Coordinates& a, const Coordinates& b,
+                               double matrix[9]);
+        static double solveQCP(const double matrix[9], double e0);
+};
+
+#endif
@@ -0,0 +1,356 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+#include "SecondaryStructure.hpp"
+#include "SpatialGrid.hpp"
+#include "Threading/ThreadPool.hpp"
+#include <algorithm>
+#include <iostream>
+
+
+SecondaryStructure::SecondaryStructure(const TrajectoryPtr& trajectory) :
+    trajectory_(trajectory), backbone_(trajectory->getTopology())
+{}
+
+
+
+void SecondaryStructure::analyzeAll()
+{
+    std::cout << "[concurrent] Assigning secondary structure to " <<
+        trajectory_->countSnapshots() << " snapshots..." << std::endl;
+
+    using namespace std::chrono;
+    auto start = steady_clock::now();
+
+    ThreadPool::getInstance().parallelFor(
+        (std::size_t)trajectory_->countSnapshots(), 1,
+        [this](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t j = begin; j < end; j++)
+                getAssignment((int)j);
+        }
+    );
+
+    auto diff = duration_cast<microseconds>(steady_clock::now() - start).count();
+    std::cout << "[concurrent] ...done assigning secondary structure. Took " <<
+        (diff / 1000.0f) << "ms" << std::endl;
+}
+
+
+
+SecondaryStructure::AssignmentPtr
+    SecondaryStructure::getAssignment(int snapshotIndex)
+{
+    auto index = (std::size_t)snapshotIndex;
+
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex_);
+        if (cache_.size() <= index)
+            cache_.resize((std::size_t)trajectory_->countSnapshots());
+        if (cache_[index])
+            return cache_[index];
+    }
+
+    auto assignment = analyze(snapshotIndex);
+
+    std::lock_guard<std::mutex> lock(cacheMutex_);
+    cache_[index] = assignment;
+    return assignment;
+}
+
+
+
+std::string SecondaryStructure::toString(int snapshotIndex)
+{
+    auto assignment = getAssignment(snapshotIndex);
+
+    std::string str;
+    str.reserve(assignment->size());
+    for (auto structure : *assignment)
+        str.push_back((char)structure);
+    return str;
+}
+
+
+
+//the share of residues in that snapshot assigned the given structure
+float SecondaryStructure::getFraction(int snapshotIndex, Structure structure)
+{
+    auto assignment = getAssignment(snapshotIndex);
+    if (assignment->empty())
+        return 0;
+
+    auto count = std::count(assignment->begin(), assignment->end(), structure);
+    return count / (float)assignment->size();
+}
+
+
+
+const Backbone& SecondaryStructure::getBackbone() const
+{
+    return backbone_;
+}
+
+
+
+SecondaryStructure::AssignmentPtr SecondaryStructure::analyze(int snapshotIndex)
+{
+    auto table = findHydrogenBonds(trajectory_->getSnapshot(snapshotIndex));
+
+    auto assignment = std::make_shared<Assignment>(
+        backbone_.countResidues(), Structure::COIL);
+
+    //DSSP's priority: alpha helix, then strands, then 3-10 and pi helices
+    assignHelices(table, 4, *assignment);
+    assignStrands(table, *assignment);
+    assignHelices(table, 3, *assignment);
+    assignHelices(table, 5, *assignment);
+
+    return assignment;
+}
+
+
+
+SecondaryStructure::HBondTable
+    SecondaryStructure::findHydrogenBonds(const SnapshotPtr& snapshot)
+{
+    const auto& RESIDUES = backbone_.getResidues();
+    HBondTable table(RESIDUES.size());
+
+    std::vector<glm::vec3> alphaCarbons;
+    alphaCarbons.reserve(RESIDUES.size());
+    for (const auto& residue : RESIDUES)
+        alphaCarbons.push_back(snapshot->getPosition(residue.ca));
+
+    SpatialGrid grid(alphaCarbons, MAX_CA_DISTANCE);
+    const float MAX_DISTANCE_SQUARED = MAX_CA_DISTANCE * MAX_CA_DISTANCE;
+
+    for (std::size_t donor = 1; donor < RESIDUES.size(); donor++)
+    {
+        const auto& residue = RESIDUES[donor];
+        if (!residue.linkedToPrevious || residue.isProline)
+            continue;
+
+        //the amide H sits on N, opposite the previous residue's C=O
+        const auto& previous = RESIDUES[donor - 1];
+        auto nitrogen = snapshot->getPosition(residue.n);
+        auto carbonyl = snapshot->getPosition(previous.c) -
+                        snapshot->getPosition(previous.o);
+        auto hydrogen = nitrogen + glm::normalize(carbonyl);
+
+        auto& best = table[donor];
+        grid.forEachNear(alphaCarbons[donor], [&](std::size_t acceptor)
+        {
+            if (acceptor + 1 >= donor && acceptor <= donor + 1)
+                return; //itself or a direct neighbor
+
+            auto delta = alphaCarbons[acceptor] - alphaCarbons[donor];
+            if (glm::dot(delta, delta) >= MAX_DISTANCE_SQUARED)
+                return;
+
+            float energy = calculateEnergy(snapshot, acceptor, donor, hydrogen);
+            if (energy < best[0].energy)
+            {
+                best[1] = best[0];
+                best[0].partner = acceptor;
+                best[0].energy = energy;
+            }
+            else if (energy < best[1].energy)
+            {
+                best[1].partner = acceptor;
+                best[1].energy = energy;
+            }
+        });
+    }
+
+    return table;
+}
+
+
+
+float SecondaryStructure::calculateEnergy(const SnapshotPtr& snapshot,
+    std::size_t acceptor, std::size_t donor, const glm::vec3& hydrogen)
+{
+    const auto& RESIDUES = backbone_.getResidues();
+    auto carbon   = snapshot->getPosition(RESIDUES[acceptor].c);
+    auto oxygen   = snapshot->getPosition(RESIDUES[acceptor].o);
+    auto nitrogen = snapshot->getPosition(RESIDUES[donor].n);
+
+    float distanceON = glm::distance(oxygen, nitrogen);
+    float distanceCH = glm::distance(carbon, hydrogen);
+    float distanceOH = glm::distance(oxygen, hydrogen);
+    float distanceCN = glm::distance(carbon, nitrogen);
+
+    if (distanceON < 0.5f || distanceCH < 0.5f ||
+        distanceOH < 0.5f || distanceCN < 0.5f)
+        return MIN_HBOND_ENERGY; //overlapping atoms
+
+    //q1 * q2 * f = 0.42e * 0.20e * 332 kcal*angstrom/mol
+    const float COUPLING = 0.084f * 332.0f;
+    float energy = COUPLING * (1 / distanceON + 1 / distanceCH -
+                               1 / distanceOH - 1 / distanceCN);
+    return std::max(energy, MIN_HBOND_ENERGY);
+}
+
+
+
+bool SecondaryStructure::isBonded(const HBondTable& table,
+                                  std::size_t acceptor, std::size_t donor)
+{
+    if (donor >= table.size())
+        return false;
+
+    for (const auto& bond : table[donor])
+        if (bond.partner == acceptor && bond.energy < HBOND_ENERGY_CUTOFF)
+            return true;
+    return false;
+}
+
+
+
+//true if residues [from, to] form one unbroken stretch of chain
+bool SecondaryStructure::isContiguous(std::size_t from, std::size_t to)
+{
+    const auto& RESIDUES = backbone_.getResidues();
+    if (to >= RESIDUES.size())
+        return false;
+
+    for (auto j = from + 1; j <= to; j++)
+        if (!RESIDUES[j].linkedToPrevious)
+            return false;
+    return true;
+}
+
+
+
+void SecondaryStructure::assignHelices(const HBondTable& table, int turn,
+                                       Assignment& assignment)
+{
+    //an n-turn at i is the bond CO(i) -> NH(i + n), and two consecutive
+    //n-turns at i - 1 and i make residues i to i + n - 1 helical
+    auto n = (std::size_t)turn;
+    for (std::size_t j = 1; j + n < assignment.size(); j++)
+    {
+        if (!isContiguous(j - 1, j + n))
+            continue;
+
+        if (!isBonded(table, j - 1, j - 1 + n) || !isBonded(table, j, j + n))
+            continue;
+
+        bool free = true;
+        for (std::size_t k = j; k < j + n; k++)
+            if (turn != 4 && assignment[k] != Structure::COIL)
+                free = false;
+
+        if (free)
+            for (std::size_t k = j; k < j + n; k++)
+                assignment[k] = Structure::HELIX;
+    }
+}
+
+
+
+void SecondaryStructure::assignStrands(const HBondTable& table,
+                                       Assignment& assignment)
+{
+    //gather, for every residue, the residues it is hydrogen bonded to
+    std::vector<std::vector<std::size_t>> partners(assignment.size());
+    for (std::size_t donor = 0; donor < table.size(); donor++)
+    {
+        for (const auto& bond : table[donor])
+        {
+            if (bond.energy >= HBOND_ENERGY_CUTOFF)
+                continue;
+            partners[donor].push_back(bond.partner);
+            partners[bond.partner].push_back(donor);
+        }
+    }
+
+    Bridges parallels, antiparallels;
+    for (std::size_t i = 1; i + 1 < assignment.size(); i++)
+    {
+        if (!isContiguous(i - 1, i + 1))
+            continue;
+
+        //a bridge partner j of i must bond to i - 1, i, or i + 1, or to j +- 1
+        std::vector<std::size_t> candidates;
+        for (auto k = i - 1; k <= i + 1; k++)
+            for (auto partner : partners[k])
+                for (auto j = partner; j <= partner + 2; j++)
+                    if (j > 0)
+                        candidates.push_back(j - 1);
+
+        std::sort(candidates.begin(), candidates.end());
+        auto last = std::unique(candidates.begin(), candidates.end());
+
+        for (auto j = candidates.begin(); j != last; j++)
+        {
+            if (*j <= i + 2 || *j + 1 >= assignment.size())
+                continue; //seen from the other side, or too close along the chain
+            if (!isContiguous(*j - 1, *j + 1))
+                continue;
+
+            if ((isBonded(table, i - 1, *j) && isBonded(table, *j, i + 1)) ||
+                (isBonded(table, *j - 1, i) && isBonded(table, i, *j + 1)))
+                parallels.insert(std::make_pair(i, *j));
+
+            if ((isBonded(table, i, *j) && isBonded(table, *j, i)) ||
+                (isBonded(table, i - 1, *j + 1) && isBonded(table, *j - 1, i + 1)))
+                antiparallels.insert(std::make_pair(i, *j));
+        }
+    }
+
+    assignLadders(parallels, 1, assignment);
+    assignLadders(antiparallels, -1, assignment);
+}
+
+
+
+//consecutive bridges (i, j) and (i + 1, j + direction) form a ladder
+void SecondaryStructure::assignLadders(const Bridges& bridges, int direction,
+                                       Assignment& assignment)
+{
+    auto mark = [&](std::size_t residue, Structure structure)
+    {
+        auto& current = assignment[residue];
+        if (current == Structure::COIL ||
+            (current == Structure::BRIDGE && structure == Structure::STRAND))
+            current = structure;
+    };
+
+    for (const auto& bridge : bridges)
+    {
+        auto i = bridge.first, j = bridge.second;
+        auto next = std::make_pair(i + 1, j + (std::size_t)direction);
+        auto previous = std::make_pair(i - 1, j - (std::size_t)direction);
+
+        auto structure = Structure::BRIDGE;
+        if (bridges.count(next) > 0 || bridges.count(previous) > 0)
+            structure = Structure::STRAND;
+
+        mark(i, structure);
+        mark(j, structure);
+    }
+}
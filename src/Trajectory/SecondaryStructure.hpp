@@ -0,0 +1,112 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+#ifndef SECONDARY_STRUCTURE
+#define SECONDARY_STRUCTURE
+
+/**
+    Assigns secondary structure to every residue of every snapshot, following
+    the method of DSSP (Kabsch & Sander, 1983). Backbone hydrogen bonds are
+    found with DSSP's electrostatic energy model: the amide hydrogen is placed
+    opposite the previous residue's carbonyl, and a bond CO(i) -> NH(j) exists
+    if its energy is below -0.5 kcal/mol. Only residues whose alpha carbons
+    are within 9 angstroms can bond, so candidate pairs come from a
+    SpatialGrid. As in DSSP, each donor keeps its two strongest acceptors.
+    Repeated n-turns then mark helices (alpha, 3-10, and pi helices all report
+    as HELIX) and bridge patterns mark strands, everything else being coil. As
+    in DSSP, only ladders of two or more consecutive bridges count as STRAND,
+    and a lone bridge is reported as BRIDGE. Snapshots are independent, so
+    analyzeAll() processes them in parallel on the ThreadPool. Results are
+    cached per snapshot, so rendering code can ask for them every frame at no
+    cost.
+**/
+
+#include "Trajectory.hpp"
+#include "Backbone.hpp"
+#include <memory>
+#include <string>
+#include <array>
+#include <set>
+#include <mutex>
+
+class SecondaryStructure
+{
+    public:
+        enum class Structure : char
+        {
+            COIL = 'C', HELIX = 'H', STRAND = 'E', BRIDGE = 'B'
+        };
+
+        typedef std::vector<Structure> Assignment; //one entry per residue
+        typedef std::shared_ptr<const Assignment> AssignmentPtr;
+
+        const float HBOND_ENERGY_CUTOFF = -0.5f; //kcal/mol
+        const float MIN_HBOND_ENERGY = -9.9f;
+        const float MAX_CA_DISTANCE = 9.0f;
+
+    public:
+        SecondaryStructure(const TrajectoryPtr& trajectory);
+        void analyzeAll();
+        AssignmentPtr getAssignment(int snapshotIndex);
+        std::string toString(int snapshotIndex);
+        float getFraction(int snapshotIndex, Structure structure);
+        const Backbone& getBackbone() const;
+
+    private:
+        struct HBond
+        {
+            std::size_t partner = (std::size_t)-1;
+            float energy = 0;
+        };
+
+        //for donor residue j, the two strongest acceptors CO(i) -> NH(j)
+        typedef std::vector<std::array<HBond, 2>> HBondTable;
+
+        //residues (i, j), i < j, whose hydrogen bonds pair them in a sheet
+        typedef std::set<std::pair<std::size_t, std::size_t>> Bridges;
+
+        AssignmentPtr analyze(int snapshotIndex);
+        HBondTable findHydrogenBonds(const SnapshotPtr& snapshot);
+        float calculateEnergy(const SnapshotPtr& snapshot, std::size_t acceptor,
+                              std::size_t donor, const glm::vec3& hydrogen);
+        bool isBonded(const HBondTable& table, std::size_t acceptor,
+                      std::size_t donor);
+        bool isContiguous(std::size_t from, std::size_t to);
+        void assignHelices(const HBondTable& table, int turn,
+                           Assignment& assignment);
+        void assignStrands(const HBondTable& table, Assignment& assignment);
+        void assignLadders(const Bridges& bridges, int direction,
+                           Assignment& assignment);
+
+    private:
+        TrajectoryPtr trajectory_;
+        Backbone backbone_;
+        std::vector<AssignmentPtr> cache_;
+        std::mutex cacheMutex_;
+};
+
+typedef std::shared_ptr<SecondaryStructure> SecondaryStructurePtr;
+
+#endif
@@ -47,3 +47,10 @@ glm::vec3 Snapshot::getPosition(std::size_t atomIndex)
 
     return positions_[atomIndex];
 }
+
+
+
+const std::vector<glm::vec3>& Snapshot::getPositions()
+{
+    return positions_;
+}
@@ -35,6 +35,7 @@ class Snapshot
     public:
         void addPosition(const glm::vec3& position);
         glm::vec3 getPosition(std::size_t atomIndex);
+        const std::vector<glm::vec3>& getPositions();
 
     private:
         std::vector<glm::vec3> positions_;
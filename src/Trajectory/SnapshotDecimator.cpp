@@ -0,0 +1,78 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+#include "SnapshotDecimator.hpp"
+#include "RMSD.hpp"
+#include "Threading/ThreadPool.hpp"
+#include <iostream>
+
+
+SnapshotDecimator::SnapshotDecimator(float threshold) :
+    threshold_(threshold)
+{}
+
+
+
+TrajectoryPtr SnapshotDecimator::decimate(const TrajectoryPtr& trajectory)
+{
+    const int N_SNAPSHOTS = trajectory->countSnapshots();
+    if (N_SNAPSHOTS <= 2)
+        return trajectory;
+
+    auto atoms = RMSD::selectAtoms(trajectory->getTopology());
+    std::vector<RMSD::Coordinates> coordinates((std::size_t)N_SNAPSHOTS);
+    ThreadPool::getInstance().parallelFor(coordinates.size(), 1,
+        [&](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t j = begin; j < end; j++)
+                coordinates[j] = RMSD::prepare(trajectory->getSnapshot((int)j),
+                                               atoms);
+        }
+    );
+
+    auto decimated = std::make_shared<Trajectory>(trajectory->getTopology());
+    decimated->addSnapshot(trajectory->getSnapshot(0),
+                           trajectory->getOriginalIndex(0));
+
+    int lastKept = 0;
+    for (int j = 1; j < N_SNAPSHOTS - 1; j++)
+    {
+        auto rmsd = RMSD::calculate(coordinates[(std::size_t)lastKept],
+                                    coordinates[(std::size_t)j]);
+        if (rmsd >= threshold_)
+        {
+            decimated->addSnapshot(trajectory->getSnapshot(j),
+                                   trajectory->getOriginalIndex(j));
+            lastKept = j;
+        }
+    }
+
+    decimated->addSnapshot(trajectory->getSnapshot(N_SNAPSHOTS - 1),
+                           trajectory->getOriginalIndex(N_SNAPSHOTS - 1));
+
+    std::cout << "Decimation kept " << decimated->countSnapshots() << " of " <<
+        N_SNAPSHOTS << " snapshots at " << threshold_ << " A RMSD" << std::endl;
+    return decimated;
+}
@@ -0,0 +1,52 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+#ifndef SNAPSHOT_DECIMATOR
+#define SNAPSHOT_DECIMATOR
+
+/**
+    Consecutive checkpoints from FAHClient often differ very little, yet each
+    one keeps a full array of positions and costs a full interpolation segment
+    in SlotViewer. SnapshotDecimator walks the Trajectory in order and drops
+    every snapshot whose RMSD to the last kept snapshot is below a threshold,
+    always keeping the first and last ones. The result is a new Trajectory
+    sharing the same Topology, where each kept snapshot remembers its index in
+    the original timeline, so playback can still give each segment the time
+    that it originally spanned.
+**/
+
+#include "Trajectory.hpp"
+
+class SnapshotDecimator
+{
+    public:
+        SnapshotDecimator(float threshold);
+        TrajectoryPtr decimate(const TrajectoryPtr& trajectory);
+
+    private:
+        float threshold_; //angstroms of RMSD
+};
+
+#endif
@@ -0,0 +1,108 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+#include "SpatialGrid.hpp"
+#include <cfloat>
+#include <cmath>
+
+
+SpatialGrid::SpatialGrid(const std::vector<glm::vec3>& points, float cellSize) :
+    origin_(0), cellSize_(cellSize), dimensions_(1)
+{
+    if (points.empty())
+    {
+        cellStarts_.assign(2, 0);
+        return;
+    }
+
+    glm::vec3 minimum(FLT_MAX), maximum(-FLT_MAX);
+    for (auto point : points)
+    {
+        minimum = glm::min(minimum, point);
+        maximum = glm::max(maximum, point);
+    }
+
+    //a few stray atoms far away must not blow up the cell count
+    auto extent = maximum - minimum;
+    while (true)
+    {
+        dimensions_ = glm::ivec3(extent / cellSize_) + glm::ivec3(1);
+        std::size_t nCells = (std::size_t)dimensions_.x *
+                             (std::size_t)dimensions_.y *
+                             (std::size_t)dimensions_.z;
+        if (nCells <= MAX_CELLS)
+            break;
+        cellSize_ *= 2;
+    }
+    origin_ = minimum;
+
+    //counting sort of the points by cell
+    std::vector<std::size_t> cellOfPoint(points.size());
+    cellStarts_.assign(getCellIndex(dimensions_ - glm::ivec3(1)) + 2, 0);
+    for (std::size_t j = 0; j < points.size(); j++)
+    {
+        cellOfPoint[j] = getCellIndex(getCell(points[j]));
+        cellStarts_[cellOfPoint[j] + 1]++;
+    }
+
+    for (std::size_t j = 1; j < cellStarts_.size(); j++)
+        cellStarts_[j] += cellStarts_[j - 1];
+
+    auto cursors = cellStarts_;
+    sortedIndexes_.resize(points.size());
+    for (std::size_t j = 0; j < points.size(); j++)
+        sortedIndexes_[cursors[cellOfPoint[j]]++] = j;
+}
+
+
+
+float SpatialGrid::getCellSize() const
+{
+    return cellSize_;
+}
+
+
+
+std::size_t SpatialGrid::countPoints() const
+{
+    return sortedIndexes_.size();
+}
+
+
+
+glm::ivec3 SpatialGrid::getCell(const glm::vec3& position) const
+{
+    auto cell = glm::ivec3(glm::floor((position - origin_) / cellSize_));
+    return glm::clamp(cell, glm::ivec3(0), dimensions_ - glm::ivec3(1));
+}
+
+
+
+std::size_t SpatialGrid::getCellIndex(const glm::ivec3& cell) const
+{
+    return ((std::size_t)cell.x * (std::size_t)dimensions_.y +
+            (std::size_t)cell.y) * (std::size_t)dimensions_.z +
+            (std::size_t)cell.z;
+}
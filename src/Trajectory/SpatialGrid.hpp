@@ -0,0 +1,99 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+#ifndef SPATIAL_GRID
+#define SPATIAL_GRID
+
+/**
+    A SpatialGrid is a cell list: it hashes a set of points into cubic cells
+    whose edge is at least the largest distance that will be queried. Every
+    point within that distance of a query point is then guaranteed to lie in
+    the query's cell or in one of the 26 cells around it, which turns
+    all-pairs searches from O(n^2) into roughly O(n). The points are stored
+    sorted by cell (a counting sort), so each cell is a contiguous range and
+    the structure costs two flat arrays regardless of how sparse space is.
+**/
+
+#include "glm/glm.hpp"
+#include <vector>
+
+class SpatialGrid
+{
+    public:
+        SpatialGrid(const std::vector<glm::vec3>& points, float cellSize);
+
+        //calls visitor(index) for every point in the 3x3x3 block of cells
+        //around the given position. The caller applies the exact cutoff.
+        template <typename Visitor>
+        void forEachNear(const glm::vec3& position, const Visitor& visitor) const;
+
+        float getCellSize() const;
+        std::size_t countPoints() const;
+
+    private:
+        glm::ivec3 getCell(const glm::vec3& position) const;
+        std::size_t getCellIndex(const glm::ivec3& cell) const;
+
+    private:
+        const std::size_t MAX_CELLS = 1 << 22;
+
+        glm::vec3 origin_;
+        float cellSize_;
+        glm::ivec3 dimensions_;
+        std::vector<std::size_t> cellStarts_; //cell c is [starts[c], starts[c+1])
+        std::vector<std::size_t> sortedIndexes_;
+};
+
+
+
+template <typename Visitor>
+void SpatialGrid::forEachNear(const glm::vec3& position,
+                              const Visitor& visitor) const
+{
+    auto center = getCell(position);
+    for (int x = center.x - 1; x <= center.x + 1; x++)
+    {
+        if (x < 0 || x >= dimensions_.x)
+            continue;
+
+        for (int y = center.y - 1; y <= center.y + 1; y++)
+        {
+            if (y < 0 || y >= dimensions_.y)
+                continue;
+
+            for (int z = center.z - 1; z <= center.z + 1; z++)
+            {
+                if (z < 0 || z >= dimensions_.z)
+                    continue;
+
+                auto cell = getCellIndex(glm::ivec3(x, y, z));
+                for (auto j = cellStarts_[cell]; j < cellStarts_[cell + 1]; j++)
+                    visitor(sortedIndexes_[j]);
+            }
+        }
+    }
+}
+
+#endif
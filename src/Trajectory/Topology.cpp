@@ -33,14 +33,14 @@ Topology::Topology(const std::vector<AtomPtr>& atoms,
 
 
 
-std::vector<AtomPtr> Topology::getAtoms()
+const std::vector<AtomPtr>& Topology::getAtoms()
 {
     return atoms_;
 }
 
 
 
-std::vector<Bond> Topology::getBonds()
+const std::vector<Bond>& Topology::getBonds()
 {
     return bonds_;
 }
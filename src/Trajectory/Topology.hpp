@@ -45,8 +45,8 @@ class Topology
     public:
         Topology(const std::vector<AtomPtr>& atoms,
                  const std::vector<Bond>& bonds);
-        std::vector<AtomPtr> getAtoms();
-        std::vector<Bond>    getBonds();
+        const std::vector<AtomPtr>& getAtoms();
+        const std::vector<Bond>&    getBonds();
 
     private:
         std::vector<AtomPtr> atoms_;
@@ -76,8 +76,17 @@ BoundingBoxPtr Trajectory::calculateBoundingBox()
 
 
 void Trajectory::addSnapshot(const SnapshotPtr& newSnapshot)
+{
+    addSnapshot(newSnapshot,
+        originalIndexes_.empty() ? 0 : originalIndexes_.back() + 1);
+}
+
+
+
+void Trajectory::addSnapshot(const SnapshotPtr& newSnapshot, int originalIndex)
 {
     snapshots_.push_back(newSnapshot);
+    originalIndexes_.push_back(originalIndex);
 }
 
 
@@ -89,6 +98,13 @@ SnapshotPtr Trajectory::getSnapshot(int index)
 
 
 
+int Trajectory::getOriginalIndex(int index)
+{
+    return originalIndexes_[(std::size_t)index];
+}
+
+
+
 int Trajectory::countSnapshots()
 {
     return (int)snapshots_.size();
@@ -35,6 +35,8 @@
     atoms to their positions. This allows for direct and efficient lookup
     of an atom's position without needing to know the atom's index, which can
     be useful for certain algorithms such as the ones in ProteinAnalysis.cpp.
+    Each snapshot also records its index in the original timeline, which only
+    differs from its current index once some snapshots have been decimated.
 **/
 
 #include "Topology.hpp"
@@ -49,12 +51,15 @@ class Trajectory
         BoundingBoxPtr calculateBoundingBox();
 
         void addSnapshot(const SnapshotPtr& newSnapshot);
+        void addSnapshot(const SnapshotPtr& newSnapshot, int originalIndex);
         SnapshotPtr getSnapshot(int index);
+        int getOriginalIndex(int index);
         int countSnapshots();
 
     private:
         std::shared_ptr<Topology> topology_;
         std::vector<SnapshotPtr> snapshots_;
+        std::vector<int> originalIndexes_;
 };
 
 typedef std::shared_ptr<Trajectory> TrajectoryPtr;
@@ -0,0 +1,335 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+#include "InstanceTransforms.hpp"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+static_assert(sizeof(glm::vec3) == 3 * sizeof(float),
+    "positions must be tightly packed for the batch kernels");
+static_assert(sizeof(glm::mat4) == 16 * sizeof(float),
+    "matrices must be tightly packed for the batch kernels");
+
+
+//positions = positionsA + (positionsB - positionsA) * blend + offset
+void InstanceTransforms::interpolate(const glm::vec3* positionsA,
+                                     const glm::vec3* positionsB,
+                                     float blend, const glm::vec3& offset,
+                                     glm::vec3* positions, std::size_t count)
+{
+    const float* a = &positionsA[0].x;
+    const float* b = &positionsB[0].x;
+    float* out = &positions[0].x;
+    const std::size_t N_FLOATS = count * 3;
+    std::size_t j = 0;
+
+#ifdef __SSE2__
+    //four positions are twelve floats, so the offset repeats every 3 registers
+    const __m128 BLEND = _mm_set1_ps(blend);
+    const __m128 OFFSETS[3] = {
+        _mm_setr_ps(offset.x, offset.y, offset.z, offset.x),
+        _mm_setr_ps(offset.y, offset.z, offset.x, offset.y),
+        _mm_setr_ps(offset.z, offset.x, offset.y, offset.z)
+    };
+
+    for (; j + 12 <= N_FLOATS; j += 12)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            __m128 start = _mm_loadu_ps(a + j + k * 4);
+            __m128 end   = _mm_loadu_ps(b + j + k * 4);
+            __m128 delta = _mm_mul_ps(_mm_sub_ps(end, start), BLEND);
+            _mm_storeu_ps(out + j + k * 4,
+                _mm_add_ps(_mm_add_ps(start, delta), OFFSETS[k]));
+        }
+    }
+#endif
+
+    for (; j < N_FLOATS; j++)
+        out[j] = a[j] + (b[j] - a[j]) * blend + offset[(int)(j % 3)];
+}
+
+
+
+void InstanceTransforms::generateAtomMatrices(const glm::vec3* positions,
+                                              const float* scales,
+                                              glm::mat4* matrices,
+                                              std::size_t count)
+{
+    std::size_t j = 0;
+
+#ifdef __SSE2__
+    const __m128 LANE_X = _mm_castsi128_ps(_mm_setr_epi32(-1, 0, 0, 0));
+    const __m128 LANE_Y = _mm_castsi128_ps(_mm_setr_epi32(0, -1, 0, 0));
+    const __m128 LANE_Z = _mm_castsi128_ps(_mm_setr_epi32(0, 0, -1, 0));
+
+    for (; j + 4 <= count; j += 4)
+    {
+        __m128 fourScales = _mm_loadu_ps(scales + j);
+        __m128 splats[4] = {
+            _mm_shuffle_ps(fourScales, fourScales, _MM_SHUFFLE(0, 0, 0, 0)),
+            _mm_shuffle_ps(fourScales, fourScales, _MM_SHUFFLE(1, 1, 1, 1)),
+            _mm_shuffle_ps(fourScales, fourScales, _MM_SHUFFLE(2, 2, 2, 2)),
+            _mm_shuffle_ps(fourScales, fourScales, _MM_SHUFFLE(3, 3, 3, 3))
+        };
+
+        for (int k = 0; k < 4; k++)
+        { //scale along the diagonal, position in the last column
+            const auto& position = positions[j + k];
+            float* matrix = &matrices[j + k][0][0];
+            _mm_storeu_ps(matrix,      _mm_and_ps(splats[k], LANE_X));
+            _mm_storeu_ps(matrix + 4,  _mm_and_ps(splats[k], LANE_Y));
+            _mm_storeu_ps(matrix + 8,  _mm_and_ps(splats[k], LANE_Z));
+            _mm_storeu_ps(matrix + 12,
+                _mm_setr_ps(position.x, position.y, position.z, 1));
+        }
+    }
+#endif
+
+    for (; j < count; j++)
+        matrices[j] = atomMatrix(positions[j], scales[j]);
+}
+
+
+
+#ifdef __SSE2__
+//builds four bond matrices from their start points and (unnormalized) axes
+static void storeBondMatrices(__m128 sx, __m128 sy, __m128 sz,
+                              __m128 dx, __m128 dy, __m128 dz,
+                              __m128 width, glm::mat4* matrices)
+{
+    const __m128 ZERO = _mm_setzero_ps();
+    const __m128 ONE = _mm_set1_ps(1);
+    const __m128 MINUS_ONE = _mm_set1_ps(-1);
+    const __m128 EPSILON = _mm_set1_ps(FLT_EPSILON);
+
+    __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx),
+        _mm_add_ps(_mm_mul_ps(dy, dy), _mm_mul_ps(dz, dz))));
+
+    //unit axis, or +z for bonds between coincident atoms
+    __m128 valid = _mm_cmpgt_ps(length, EPSILON);
+    length = _mm_and_ps(valid, length);
+    __m128 inverse = _mm_div_ps(ONE, _mm_or_ps(length, _mm_andnot_ps(valid, ONE)));
+    __m128 wx = _mm_mul_ps(dx, _mm_and_ps(valid, inverse));
+    __m128 wy = _mm_mul_ps(dy, _mm_and_ps(valid, inverse));
+    __m128 wz = _mm_or_ps(_mm_and_ps(valid, _mm_mul_ps(dz, inverse)),
+                          _mm_andnot_ps(valid, ONE));
+
+    //Duff et al. (2017), branchless
+    __m128 positive = _mm_cmpge_ps(wz, ZERO);
+    __m128 sign = _mm_or_ps(_mm_and_ps(positive, ONE),
+                            _mm_andnot_ps(positive, MINUS_ONE));
+    __m128 a = _mm_div_ps(MINUS_ONE, _mm_add_ps(sign, wz));
+    __m128 b = _mm_mul_ps(_mm_mul_ps(wx, wy), a);
+
+    __m128 ux = _mm_add_ps(ONE, _mm_mul_ps(sign, _mm_mul_ps(_mm_mul_ps(wx, wx), a)));
+    __m128 uy = _mm_mul_ps(sign, b);
+    __m128 uz = _mm_sub_ps(ZERO, _mm_mul_ps(sign, wx));
+    __m128 vx = b;
+    __m128 vy = _mm_add_ps(sign, _mm_mul_ps(_mm_mul_ps(wy, wy), a));
+    __m128 vz = _mm_sub_ps(ZERO, wy);
+
+    float columns[12][4];
+    _mm_storeu_ps(columns[0],  _mm_mul_ps(ux, width));
+    _mm_storeu_ps(columns[1],  _mm_mul_ps(uy, width));
+    _mm_storeu_ps(columns[2],  _mm_mul_ps(uz, width));
+    _mm_storeu_ps(columns[3],  _mm_mul_ps(vx, width));
+    _mm_storeu_ps(columns[4],  _mm_mul_ps(vy, width));
+    _mm_storeu_ps(columns[5],  _mm_mul_ps(vz, width));
+    _mm_storeu_ps(columns[6],  _mm_mul_ps(wx, length));
+    _mm_storeu_ps(columns[7],  _mm_mul_ps(wy, length));
+    _mm_storeu_ps(columns[8],  _mm_mul_ps(wz, length));
+    _mm_storeu_ps(columns[9],  sx);
+    _mm_storeu_ps(columns[10], sy);
+    _mm_storeu_ps(columns[11], sz);
+
+    for (int k = 0; k < 4; k++)
+    {
+        float* matrix = &matrices[k][0][0];
+        for (int c = 0; c < 4; c++)
+        {
+            matrix[c * 4 + 0] = columns[c * 3 + 0][k];
+            matrix[c * 4 + 1] = columns[c * 3 + 1][k];
+            matrix[c * 4 + 2] = columns[c * 3 + 2][k];
+            matrix[c * 4 + 3] = 0;
+        }
+        matrix[15] = 1;
+    }
+}
+#endif
+
+
+
+void InstanceTransforms::generateBondMatrices(const glm::vec3* atomPositions,
+                                              const Bond* bonds, float width,
+                                              glm::mat4* matrices,
+                                              std::size_t count)
+{
+    std::size_t j = 0;
+
+#ifdef __SSE2__
+    const __m128 WIDTH = _mm_set1_ps(width);
+    for (; j + 4 <= count; j += 4)
+    {
+        //gather four bonds into separate x, y, and z registers
+        const glm::vec3* s[4];
+        const glm::vec3* e[4];
+        for (int k = 0; k < 4; k++)
+        {
+            s[k] = &atomPositions[bonds[j + k].first];
+            e[k] = &atomPositions[bonds[j + k].second];
+        }
+
+        __m128 sx = _mm_setr_ps(s[0]->x, s[1]->x, s[2]->x, s[3]->x);
+        __m128 sy = _mm_setr_ps(s[0]->y, s[1]->y, s[2]->y, s[3]->y);
+        __m128 sz = _mm_setr_ps(s[0]->z, s[1]->z, s[2]->z, s[3]->z);
+        __m128 dx = _mm_sub_ps(_mm_setr_ps(e[0]->x, e[1]->x, e[2]->x, e[3]->x), sx);
+        __m128 dy = _mm_sub_ps(_mm_setr_ps(e[0]->y, e[1]->y, e[2]->y, e[3]->y), sy);
+        __m128 dz = _mm_sub_ps(_mm_setr_ps(e[0]->z, e[1]->z, e[2]->z, e[3]->z), sz);
+        storeBondMatrices(sx, sy, sz, dx, dy, dz, WIDTH, matrices + j);
+    }
+#endif
+
+    for (; j < count; j++)
+        matrices[j] = bondMatrix(atomPositions[bonds[j].first],
+                                 atomPositions[bonds[j].second], width);
+}
+
+
+
+//same as generateBondMatrices, but from the bonds' start points and axes at
+//two snapshots, which blend linearly. Each block holds four bonds as
+//start x, y, z and axis x, y, z, four lanes apiece, so they load directly.
+void InstanceTransforms::blendBondMatrices(const float* blocksA,
+                                           const float* blocksB,
+                                           std::size_t first, float blend,
+                                           const glm::vec3& offset, float width,
+                                           glm::mat4* matrices, std::size_t count)
+{
+    const std::size_t END = first + count;
+    std::size_t j = first;
+
+#ifdef __SSE2__
+    //bonds up to the next block boundary go through the scalar path
+    std::size_t alignedEnd = std::min((first + 3) / 4 * 4, END);
+    for (; j < alignedEnd; j++)
+        matrices[j - first] = blendBondMatrix(blocksA, blocksB, j, blend,
+                                              offset, width);
+
+    const __m128 BLEND = _mm_set1_ps(blend);
+    const __m128 WIDTH = _mm_set1_ps(width);
+    const __m128 OFFSETS[3] = {
+        _mm_set1_ps(offset.x), _mm_set1_ps(offset.y), _mm_set1_ps(offset.z)
+    };
+
+    for (; j + 4 <= END; j += 4)
+    {
+        const float* a = blocksA + j / 4 * BOND_BLOCK_SIZE;
+        const float* b = blocksB + j / 4 * BOND_BLOCK_SIZE;
+
+        __m128 values[6];
+        for (int k = 0; k < 6; k++)
+        {
+            __m128 start = _mm_loadu_ps(a + k * 4);
+            __m128 delta = _mm_sub_ps(_mm_loadu_ps(b + k * 4), start);
+            values[k] = _mm_add_ps(start, _mm_mul_ps(delta, BLEND));
+        }
+
+        storeBondMatrices(_mm_add_ps(values[0], OFFSETS[0]),
+                          _mm_add_ps(values[1], OFFSETS[1]),
+                          _mm_add_ps(values[2], OFFSETS[2]),
+                          values[3], values[4], values[5],
+                          WIDTH, matrices + (j - first));
+    }
+#endif
+
+    for (; j < END; j++)
+        matrices[j - first] = blendBondMatrix(blocksA, blocksB, j, blend,
+                                              offset, width);
+}
+
+
+
+glm::mat4 InstanceTransforms::atomMatrix(const glm::vec3& position, float scale)
+{
+    glm::mat4 matrix(scale);
+    matrix[3] = glm::vec4(position, 1);
+    return matrix;
+}
+
+
+
+//maps the unit bond along +z onto the segment, with the given cross-section
+glm::mat4 InstanceTransforms::bondMatrix(const glm::vec3& startPosition,
+                                         const glm::vec3& endPosition,
+                                         float width)
+{
+    glm::vec3 axis = endPosition - startPosition;
+    float length = std::sqrt(glm::dot(axis, axis));
+    glm::vec3 w(0, 0, 1);
+    if (length > FLT_EPSILON)
+        w = axis / length;
+    else
+        length = 0;
+
+    float s = w.z >= 0 ? 1.0f : -1.0f;
+    float a = -1.0f / (s + w.z);
+    float b = w.x * w.y * a;
+    glm::vec3 u(1 + s * w.x * w.x * a, s * b, -s * w.x);
+    glm::vec3 v(b, s + w.y * w.y * a, -w.y);
+
+    glm::mat4 matrix;
+    matrix[0] = glm::vec4(u * width, 0);
+    matrix[1] = glm::vec4(v * width, 0);
+    matrix[2] = glm::vec4(w * length, 0);
+    matrix[3] = glm::vec4(startPosition, 1);
+    return matrix;
+}
+
+
+
+glm::mat4 InstanceTransforms::blendBondMatrix(const float* blocksA,
+                                              const float* blocksB,
+                                              std::size_t index, float blend,
+                                              const glm::vec3& offset,
+                                              float width)
+{
+    std::size_t base = index / 4 * BOND_BLOCK_SIZE + index % 4;
+    float values[6];
+    for (int k = 0; k < 6; k++)
+    {
+        float start = blocksA[base + k * 4];
+        values[k] = start + (blocksB[base + k * 4] - start) * blend;
+    }
+
+    glm::vec3 start = glm::vec3(values[0], values[1], values[2]) + offset;
+    glm::vec3 axis(values[3], values[4], values[5]);
+    return bondMatrix(start, start + axis, width);
+}
@@ -0,0 +1,78 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+#ifndef INSTANCE_TRANSFORMS
+#define INSTANCE_TRANSFORMS
+
+/**
+    Batch kernels that turn interpolated atom positions into the model
+    matrices of the atom and bond instances. They work on whole arrays at
+    once, four atoms or bonds per iteration with SSE2 (or a scalar fallback),
+    instead of composing glm::translate, glm::rotate, and glm::scale for every
+    instance. Bonds are oriented with the closed-form orthonormal basis of
+    Duff et al. (2017), the same one the bond vertex shader uses when the GPU
+    does the interpolation, so there is no acos and no axis-angle rotation.
+    blendBondMatrices() builds the same matrices from two of the
+    KeyframeCache's per-snapshot blocks rather than from atom positions.
+    The single-instance versions are used for the remainder of each batch
+    and when the instances are first created.
+**/
+
+#include "Trajectory/Topology.hpp"
+#include "glm/glm.hpp"
+#include <vector>
+
+class InstanceTransforms
+{
+    public:
+        static void interpolate(const glm::vec3* positionsA,
+                                const glm::vec3* positionsB,
+                                float blend, const glm::vec3& offset,
+                                glm::vec3* positions, std::size_t count);
+        static void generateAtomMatrices(const glm::vec3* positions,
+                                         const float* scales,
+                                         glm::mat4* matrices, std::size_t count);
+        static void generateBondMatrices(const glm::vec3* atomPositions,
+                                         const Bond* bonds, float width,
+                                         glm::mat4* matrices, std::size_t count);
+        static void blendBondMatrices(const float* blocksA,
+                                      const float* blocksB,
+                                      std::size_t first, float blend,
+                                      const glm::vec3& offset, float width,
+                                      glm::mat4* matrices, std::size_t count);
+
+        static glm::mat4 atomMatrix(const glm::vec3& position, float scale);
+        static glm::mat4 bondMatrix(const glm::vec3& startPosition,
+                                    const glm::vec3& endPosition, float width);
+        static glm::mat4 blendBondMatrix(const float* blocksA,
+                                         const float* blocksB,
+                                         std::size_t index, float blend,
+                                         const glm::vec3& offset, float width);
+
+    public:
+        static const std::size_t BOND_BLOCK_SIZE = 24; //floats per four bonds
+};
+
+#endif
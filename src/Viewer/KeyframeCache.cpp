@@ -0,0 +1,174 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+#include "KeyframeCache.hpp"
+#include "Threading/ThreadPool.hpp"
+
+
+KeyframeCache::KeyframeCache(const TrajectoryPtr& trajectory,
+                             std::size_t budget) :
+    trajectory_(trajectory), bonds_(trajectory->getTopology()->getBonds()),
+    budget_(budget)
+{}
+
+
+
+//builds keyframes in the given order, but stops rather than evicting any
+void KeyframeCache::precompute(const std::vector<int>& snapshotIndexes)
+{
+    for (int index : snapshotIndexes)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if ((keyframes_.size() + 1) * getKeyframeSize() > budget_)
+                return;
+            if (keyframes_.count(index) > 0 || !pending_.insert(index).second)
+                continue;
+        }
+
+        insert(index, build(index));
+    }
+}
+
+
+
+//builds the keyframe in the background unless it is cached or on its way
+void KeyframeCache::prefetch(int snapshotIndex)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (keyframes_.count(snapshotIndex) > 0 || getKeyframeSize() > budget_)
+            return; //it's ready, or it would never fit
+        if (!pending_.insert(snapshotIndex).second)
+            return; //it's already on its way
+    }
+
+    auto self = shared_from_this();
+    ThreadPool::getInstance().enqueue([self, snapshotIndex]()
+    {
+        self->load(snapshotIndex);
+    });
+}
+
+
+
+KeyframeCache::KeyframePtr KeyframeCache::get(int snapshotIndex)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto iterator = keyframes_.find(snapshotIndex);
+        if (iterator != keyframes_.end())
+        { //mark it as the most recently used
+            auto& entry = iterator->second;
+            recentlyUsed_.splice(recentlyUsed_.begin(), recentlyUsed_,
+                                 entry.second);
+            return entry.first;
+        }
+    }
+
+    prefetch(snapshotIndex);
+    return nullptr;
+}
+
+
+
+std::size_t KeyframeCache::countKeyframes()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return keyframes_.size();
+}
+
+
+
+std::size_t KeyframeCache::getCapacity()
+{
+    return budget_ / getKeyframeSize();
+}
+
+
+
+std::size_t KeyframeCache::getKeyframeSize()
+{
+    auto nBlocks = (bonds_.size() + 3) / 4;
+    return nBlocks * InstanceTransforms::BOND_BLOCK_SIZE * sizeof(float);
+}
+
+
+
+std::size_t KeyframeCache::getMemoryUsage()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return keyframes_.size() * getKeyframeSize();
+}
+
+
+
+void KeyframeCache::load(int snapshotIndex)
+{
+    insert(snapshotIndex, build(snapshotIndex));
+}
+
+
+
+KeyframeCache::KeyframePtr KeyframeCache::build(int snapshotIndex)
+{
+    const auto& positions = trajectory_->getSnapshot(snapshotIndex)->getPositions();
+
+    auto keyframe = std::make_shared<Keyframe>();
+    auto& blocks = keyframe->bondBlocks;
+    blocks.assign(getKeyframeSize() / sizeof(float), 0); //padding stays zero
+    for (std::size_t j = 0; j < bonds_.size(); j++)
+    {
+        const auto& start = positions[bonds_[j].first];
+        auto axis = positions[bonds_[j].second] - start;
+
+        float* lane = &blocks[j / 4 * InstanceTransforms::BOND_BLOCK_SIZE + j % 4];
+        for (int k = 0; k < 3; k++)
+        {
+            lane[k * 4] = start[k];
+            lane[(k + 3) * 4] = axis[k];
+        }
+    }
+
+    return keyframe;
+}
+
+
+
+void KeyframeCache::insert(int snapshotIndex, const KeyframePtr& keyframe)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_.erase(snapshotIndex);
+
+    recentlyUsed_.push_front(snapshotIndex);
+    keyframes_[snapshotIndex] = std::make_pair(keyframe, recentlyUsed_.begin());
+
+    //keyframes still being blended stay alive until their users let go
+    while (keyframes_.size() * getKeyframeSize() > budget_)
+    {
+        keyframes_.erase(recentlyUsed_.back());
+        recentlyUsed_.pop_back();
+    }
+}
@@ -0,0 +1,93 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+#ifndef KEYFRAME_CACHE
+#define KEYFRAME_CACHE
+
+/**
+    The KeyframeCache stores, for each snapshot, the start point and the axis
+    of every bond, in blocks of four bonds that the SSE kernels load as is.
+    With two of those keyframes the animation only has to blend contiguous
+    arrays and build each bond's basis, instead of gathering both atoms of
+    every bond from the interpolated positions on every tick. Both quantities
+    blend exactly, since the atoms themselves move linearly between
+    snapshots. Atoms need no keyframe: their matrices are just their
+    interpolated positions and a fixed scale.
+
+    Keyframes are built on the ThreadPool: precompute() fills the cache in
+    playback order until the memory budget is reached, prefetch() schedules a
+    keyframe that will soon be needed, and get() schedules any keyframe that
+    is missing and returns null until it is ready. When the budget is
+    exceeded, the least recently used keyframes are evicted, so a trajectory
+    that does not fit streams through the cache just ahead of the animation.
+**/
+
+#include "Trajectory/Trajectory.hpp"
+#include "InstanceTransforms.hpp"
+#include <unordered_map>
+#include <unordered_set>
+#include <mutex>
+#include <list>
+
+class KeyframeCache : public std::enable_shared_from_this<KeyframeCache>
+{
+    public:
+        struct Keyframe
+        {
+            std::vector<float> bondBlocks; //see InstanceTransforms
+        };
+
+        typedef std::shared_ptr<const Keyframe> KeyframePtr;
+
+    public:
+        KeyframeCache(const TrajectoryPtr& trajectory, std::size_t budget);
+        void precompute(const std::vector<int>& snapshotIndexes);
+        void prefetch(int snapshotIndex);
+        KeyframePtr get(int snapshotIndex);
+        std::size_t countKeyframes();
+        std::size_t getCapacity(); //in keyframes
+        std::size_t getKeyframeSize(); //in bytes
+        std::size_t getMemoryUsage(); //in bytes
+
+    private:
+        void load(int snapshotIndex);
+        KeyframePtr build(int snapshotIndex);
+        void insert(int snapshotIndex, const KeyframePtr& keyframe);
+
+    private:
+        typedef std::pair<KeyframePtr, std::list<int>::iterator> Entry;
+
+        TrajectoryPtr trajectory_;
+        std::vector<Bond> bonds_;
+        std::size_t budget_;
+        std::unordered_map<int, Entry> keyframes_;
+        std::list<int> recentlyUsed_; //most recent at the front
+        std::unordered_set<int> pending_; //scheduled, but not built yet
+        std::mutex mutex_;
+};
+
+typedef std::shared_ptr<KeyframeCache> KeyframeCachePtr;
+
+#endif
@@ -0,0 +1,192 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+#include "Playback.hpp"
+#include <algorithm>
+#include <iostream>
+#include <cmath>
+
+
+Playback* Playback::singleton_ = 0;
+Playback& Playback::getInstance()
+{
+    if (!singleton_)
+        singleton_ = new Playback();
+    return *singleton_;
+}
+
+
+
+Playback::Playback() :
+    anchor_(Clock::now()), anchorTime_(0), speed_(1), paused_(false),
+    changes_(0)
+{}
+
+
+
+double Playback::getTime()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return getTimeInternal();
+}
+
+
+
+Playback::State Playback::getState()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    State state;
+    state.time = getTimeInternal();
+    state.paused = paused_;
+    state.changes = changes_;
+    return state;
+}
+
+
+
+bool Playback::isPaused()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return paused_;
+}
+
+
+
+double Playback::getSpeed()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return speed_;
+}
+
+
+
+void Playback::togglePause()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    changes_++;
+    reanchor();
+    paused_ = !paused_;
+    reportState();
+}
+
+
+
+void Playback::reverse()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    changes_++;
+    reanchor();
+    speed_ = -speed_;
+    reportState();
+}
+
+
+
+void Playback::changeSpeed(double factor)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    changes_++;
+    reanchor();
+
+    double magnitude = std::abs(speed_) * factor;
+    magnitude = std::min(std::max(magnitude, MIN_SPEED), MAX_SPEED);
+    speed_ = speed_ < 0 ? -magnitude : magnitude;
+    reportState();
+}
+
+
+
+void Playback::seek(double time)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    changes_++;
+    anchor_ = Clock::now();
+    anchorTime_ = time;
+}
+
+
+
+void Playback::scrub(double deltaTime)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    changes_++;
+    reanchor();
+    anchorTime_ += deltaTime;
+}
+
+
+
+//jumps to the next (or previous) snapshot boundary of the original trajectory
+void Playback::stepSnapshot(int direction)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    changes_++;
+    reanchor();
+
+    //the small bias keeps a time sitting on a boundary from landing on itself
+    double snapshot = anchorTime_ / SNAPSHOT_DURATION;
+    if (direction > 0)
+        snapshot = std::floor(snapshot + 1e-6) + 1;
+    else
+        snapshot = std::ceil(snapshot - 1e-6) - 1;
+    anchorTime_ = snapshot * SNAPSHOT_DURATION;
+
+    std::cout << "Playback at snapshot " << (long)snapshot << std::endl;
+}
+
+
+
+double Playback::getTimeInternal()
+{
+    if (paused_)
+        return anchorTime_;
+
+    std::chrono::duration<double, std::milli> elapsed = Clock::now() - anchor_;
+    return anchorTime_ + elapsed.count() * speed_;
+}
+
+
+
+//folds the time played so far into the anchor, so that speed_ can change
+void Playback::reanchor()
+{
+    auto now = Clock::now();
+    if (!paused_)
+    {
+        std::chrono::duration<double, std::milli> elapsed = now - anchor_;
+        anchorTime_ += elapsed.count() * speed_;
+    }
+
+    anchor_ = now;
+}
+
+
+
+void Playback::reportState()
+{
+    std::cout << "Playback " << (paused_ ? "paused" : "playing") << " at " <<
+        std::abs(speed_) << "x speed" << (speed_ < 0 ? ", in reverse" : "") <<
+        std::endl;
+}
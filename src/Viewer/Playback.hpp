@@ -0,0 +1,97 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+#ifndef PLAYBACK
+#define PLAYBACK
+
+/**
+    Playback is the clock that drives the animation. Rather than adding up the
+    time that each frame claims to have taken, it remembers the moment that
+    playback last changed (the anchor) and derives the current playback time
+    from the monotonic clock: anchor time + elapsed real time * speed. Late or
+    dropped frames therefore never make the animation drift; the next frame
+    simply lands where it should be. Playback time is measured in
+    milliseconds, and SNAPSHOT_DURATION of it separates consecutive snapshots
+    of the original trajectory at normal speed. The speed is signed, so a
+    negative speed plays the trajectory in reverse. Pausing, seeking and
+    scrubbing just move the anchor, so they are all constant-time. Each of
+    them also counts as a change, so getState() lets the animation tell that
+    a paused clock is still where it was without comparing times. Playback
+    is a singleton shared by every SlotViewer so that the slots stay in step.
+**/
+
+#include <chrono>
+#include <mutex>
+
+class Playback
+{
+    public:
+        struct State
+        {
+            double time; //as getTime()
+            bool paused;
+            unsigned long changes; //pauses, seeks, and the like so far
+        };
+
+    public:
+        static Playback& getInstance();
+
+        double getTime(); //in milliseconds, may be negative
+        State getState(); //all at the same instant
+        bool isPaused();
+        double getSpeed();
+
+        void togglePause();
+        void reverse();
+        void changeSpeed(double factor);
+        void seek(double time);
+        void scrub(double deltaTime);
+        void stepSnapshot(int direction);
+
+    public:
+        const double SNAPSHOT_DURATION = 2000; //at normal speed
+        const double MIN_SPEED = 1 / 16.0, MAX_SPEED = 16;
+        const double SCRUB_STEP = SNAPSHOT_DURATION / 10;
+
+    private:
+        Playback();
+        double getTimeInternal(); //expects mutex_ to be held
+        void reanchor(); //expects mutex_ to be held
+        void reportState(); //expects mutex_ to be held
+
+    private:
+        typedef std::chrono::steady_clock Clock;
+
+        static Playback* singleton_;
+
+        std::mutex mutex_;
+        Clock::time_point anchor_;
+        double anchorTime_; //playback time at anchor_
+        double speed_; //negative when playing in reverse
+        bool paused_;
+        unsigned long changes_;
+};
+
+#endif
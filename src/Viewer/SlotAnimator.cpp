@@ -0,0 +1,389 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+#include "SlotAnimator.hpp"
+#include "InstanceTransforms.hpp"
+#include "Threading/ThreadPool.hpp"
+#include "Playback.hpp"
+#include <algorithm>
+#include <limits>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+
+
+SlotAnimator::SlotAnimator(const TrajectoryPtr& trajectory,
+                           const std::vector<int>& playbackOrder,
+                           const glm::vec3& offsetVector, bool cycleSnapshots) :
+    trajectory_(trajectory), playbackOrder_(playbackOrder),
+    offsetVector_(offsetVector), cycleSnapshots_(cycleSnapshots),
+    bondStore_(nullptr), bondScale_(1), prefetchDepth_(0),
+    snapshotIndexA_(0), snapshotIndexB_(1), timelineSegment_(0),
+    cursorDirection_(1),
+    lastTime_(std::numeric_limits<double>::quiet_NaN()),
+    instancesUpdated_(0), instancesSkipped_(0),
+    keyframeMisses_(0), stallMicroseconds_(0)
+{
+    buildTimeline();
+}
+
+
+
+//atoms must be added in order, each to the instance that draws it
+void SlotAnimator::addAtom(InstanceStore& store, std::size_t instance,
+                           float scale)
+{
+    if (std::find(atomStores_.begin(), atomStores_.end(), &store) ==
+        atomStores_.end())
+        atomStores_.push_back(&store);
+
+    atomInstances_.push_back(std::make_pair(&store, instance));
+    atomScales_.push_back(scale);
+    atomMatrices_.resize(atomInstances_.size());
+}
+
+
+
+//instance j of the store draws bond j of the topology
+void SlotAnimator::setBonds(InstanceStore& store, float scale)
+{
+    bondStore_ = &store;
+    bonds_ = trajectory_->getTopology()->getBonds();
+    bondScale_ = scale;
+    bondMatrices_.resize(bonds_.size());
+}
+
+
+
+void SlotAnimator::setKeyframes(const KeyframeCachePtr& keyframes,
+                                int prefetchDepth)
+{
+    keyframes_ = keyframes;
+    prefetchDepth_ = prefetchDepth;
+}
+
+
+
+//lays the segments end to end, measured in steps of the original trajectory
+void SlotAnimator::buildTimeline()
+{
+    segmentStarts_.clear();
+    stepSegments_.clear();
+    segmentStarts_.push_back(0);
+
+    //segments that stand in for skipped snapshots, whether decimated or left
+    //out of the representatives, take proportionally longer
+    for (std::size_t j = 0; j + 1 < playbackOrder_.size(); j++)
+    {
+        int from = trajectory_->getOriginalIndex(playbackOrder_[j]);
+        int to = trajectory_->getOriginalIndex(playbackOrder_[j + 1]);
+        int span = std::max(1, std::abs(to - from));
+        for (int k = 0; k < span; k++)
+            stepSegments_.push_back((int)j);
+        segmentStarts_.push_back(segmentStarts_.back() + span);
+    }
+}
+
+
+
+//places the atoms and bonds at this playback time and publishes them
+bool SlotAnimator::animate(double time)
+{
+    if (playbackOrder_.size() <= 1)
+        return false; //can't animate with one snapshot
+
+    if (atomInstances_.empty() && bonds_.empty())
+        return false; //we have nothing to animate
+
+    int b = updateSnapshotIndexes(time);
+    const auto& newPositions = animateAtoms(b);
+    if (bondStore_)
+        animateBonds(newPositions, b);
+
+    return true;
+}
+
+
+
+//maps a playback time straight to a segment, so seeking is as cheap as playing
+int SlotAnimator::updateSnapshotIndexes(double time)
+{
+    //Viewer skips paused frames, and a NaN lastTime_ compares false both ways
+    if (time > lastTime_)
+        cursorDirection_ = 1;
+    else if (time < lastTime_)
+        cursorDirection_ = -1;
+    lastTime_ = time;
+
+    const double LENGTH = segmentStarts_.back();
+    double step = time / Playback::getInstance().SNAPSHOT_DURATION;
+
+    bool returning = false;
+    if (cycleSnapshots_)
+    { //FAHViewer-like bouncing animation: the way back mirrors the way there
+        step = std::fmod(step, 2 * LENGTH);
+        if (step < 0)
+            step += 2 * LENGTH;
+        if (step > LENGTH)
+        {
+            step = 2 * LENGTH - step;
+            returning = true;
+        }
+    }
+    else
+    { //default jump-to-first-snapshot animation
+        step = std::fmod(step, LENGTH);
+        if (step < 0)
+            step += LENGTH;
+    }
+
+    int whole = std::min((int)step, (int)stepSegments_.size() - 1);
+    int segment = stepSegments_[whole];
+    snapshotIndexA_ = segment;
+    snapshotIndexB_ = segment + 1;
+
+    int nSegments = (int)segmentStarts_.size() - 1;
+    timelineSegment_ = returning ? 2 * nSegments - 1 - segment : segment;
+
+    double start = segmentStarts_[segment];
+    double fraction = (step - start) / (segmentStarts_[segment + 1] - start);
+    return std::min((int)(fraction * ANIMATION_SPEED), ANIMATION_SPEED);
+}
+
+
+
+const std::vector<glm::vec3>& SlotAnimator::animateAtoms(int b)
+{
+    auto snapA = trajectory_->getSnapshot(playbackOrder_[snapshotIndexA_]);
+    auto snapB = trajectory_->getSnapshot(playbackOrder_[snapshotIndexB_]);
+
+    const auto& positionsA = snapA->getPositions();
+    const auto& positionsB = snapB->getPositions();
+    if (positionsA.size() != positionsB.size())
+        throw std::runtime_error("Snapshots have different numbers of atoms!");
+
+    auto& newPositions = atomPositions_; //reused, so it only allocates once
+    newPositions.resize(positionsA.size());
+    if (lastPositions_.size() != newPositions.size())
+    { //NaN never compares as close, so every atom starts out dirty
+        lastPositions_.assign(newPositions.size(),
+            glm::vec3(std::numeric_limits<float>::quiet_NaN()));
+        atomMoved_.assign(newPositions.size(), true);
+    }
+
+    const float BLEND = b / (float)ANIMATION_SPEED;
+    const float TOLERANCE_SQUARED = MOVEMENT_TOLERANCE * MOVEMENT_TOLERANCE;
+    ThreadPool::getInstance().parallelFor(newPositions.size(), ANIMATION_CHUNK,
+        [&](std::size_t begin, std::size_t end)
+        {
+            InstanceTransforms::interpolate(&positionsA[begin],
+                &positionsB[begin], BLEND, offsetVector_,
+                &newPositions[begin], end - begin);
+
+            //compare against where the matrix was last generated, so that
+            //slow drift still gets picked up once it adds up
+            for (std::size_t j = begin; j < end; j++)
+            {
+                auto delta = newPositions[j] - lastPositions_[j];
+                atomMoved_[j] = !(glm::dot(delta, delta) <= TOLERANCE_SQUARED);
+                if (atomMoved_[j])
+                    lastPositions_[j] = newPositions[j];
+            }
+
+            if (atomInstances_.empty())
+                return;
+
+            auto updated = forEachDirtyRun(begin, end,
+                [&](std::size_t j) { return atomMoved_[j] != 0; },
+                [&](std::size_t runBegin, std::size_t runEnd)
+                {
+                    InstanceTransforms::generateAtomMatrices(
+                        &newPositions[runBegin], &atomScales_[runBegin],
+                        &atomMatrices_[runBegin], runEnd - runBegin);
+                    for (std::size_t j = runBegin; j < runEnd; j++)
+                    { //each chunk writes to its own range of instances
+                        const auto& instance = atomInstances_[j];
+                        instance.first->set(instance.second, atomMatrices_[j]);
+                    }
+                }
+            );
+
+            instancesUpdated_ += updated;
+            instancesSkipped_ += (end - begin) - updated;
+        }
+    );
+
+    for (auto store : atomStores_) //every chunk is done, so hand off the frame
+        store->publish();
+
+    return newPositions;
+}
+
+
+
+//a bond only needs a new matrix if one of its atoms moved
+void SlotAnimator::animateBonds(const std::vector<glm::vec3>& atomPositions, int b)
+{
+    KeyframeCache::KeyframePtr keyframeA, keyframeB;
+    if (keyframes_) //blend cached keyframes if both are ready
+    {
+        keyframeA = keyframes_->get(playbackOrder_[snapshotIndexA_]);
+        keyframeB = keyframes_->get(playbackOrder_[snapshotIndexB_]);
+        prefetchKeyframes();
+    }
+
+    //a miss falls back to gathering atoms, which is the time we lose to it
+    bool missed = keyframes_ && !(keyframeA && keyframeB);
+    auto startTime = std::chrono::steady_clock::now();
+
+    const float BLEND = b / (float)ANIMATION_SPEED;
+    ThreadPool::getInstance().parallelFor(bonds_.size(), ANIMATION_CHUNK,
+        [&](std::size_t begin, std::size_t end)
+        {
+            auto updated = forEachDirtyRun(begin, end,
+                [&](std::size_t j)
+                {
+                    return atomMoved_[bonds_[j].first] ||
+                           atomMoved_[bonds_[j].second];
+                },
+                [&](std::size_t runBegin, std::size_t runEnd)
+                {
+                    if (keyframeA && keyframeB)
+                        InstanceTransforms::blendBondMatrices(
+                            keyframeA->bondBlocks.data(),
+                            keyframeB->bondBlocks.data(), runBegin, BLEND,
+                            offsetVector_, bondScale_,
+                            &bondMatrices_[runBegin], runEnd - runBegin);
+                    else
+                        InstanceTransforms::generateBondMatrices(
+                            atomPositions.data(), &bonds_[runBegin], bondScale_,
+                            &bondMatrices_[runBegin], runEnd - runBegin);
+
+                    for (std::size_t j = runBegin; j < runEnd; j++)
+                        bondStore_->set(j, bondMatrices_[j]);
+                }
+            );
+
+            instancesUpdated_ += updated;
+            instancesSkipped_ += (end - begin) - updated;
+        }
+    );
+    bondStore_->publish();
+
+    if (missed)
+    {
+        auto stall = std::chrono::steady_clock::now() - startTime;
+        keyframeMisses_++;
+        stallMicroseconds_ += (std::size_t)std::chrono::duration_cast<
+            std::chrono::microseconds>(stall).count();
+    }
+}
+
+
+
+//asks for the keyframes of the next few segments in the direction of play,
+//nearest first, so that they are built before the playback reaches them
+void SlotAnimator::prefetchKeyframes()
+{
+    const int SEGMENTS = (int)playbackOrder_.size() - 1;
+    const int PERIOD = cycleSnapshots_ ?
+        2 * SEGMENTS : SEGMENTS;
+
+    for (int k = 1; k <= prefetchDepth_; k++)
+    {
+        int segment = timelineSegment_ + k * cursorDirection_;
+        segment = (segment % PERIOD + PERIOD) % PERIOD;
+        if (segment >= SEGMENTS) //on the way back of a bounce
+            segment = PERIOD - 1 - segment;
+
+        keyframes_->prefetch(playbackOrder_[segment]);
+        keyframes_->prefetch(playbackOrder_[segment + 1]);
+    }
+}
+
+
+
+int SlotAnimator::getSnapshotA()
+{
+    return playbackOrder_[snapshotIndexA_];
+}
+
+
+
+int SlotAnimator::getSnapshotB()
+{
+    return playbackOrder_[snapshotIndexB_];
+}
+
+
+
+//returns how many instances were updated and skipped since the last call
+std::pair<std::size_t, std::size_t> SlotAnimator::takeInstanceCounts()
+{
+    return std::make_pair(instancesUpdated_.exchange(0),
+                          instancesSkipped_.exchange(0));
+}
+
+
+
+//returns how many frames missed a keyframe, and the microseconds they lost,
+//since the last call
+std::pair<std::size_t, std::size_t> SlotAnimator::takeKeyframeStalls()
+{
+    return std::make_pair(keyframeMisses_.exchange(0),
+                          stallMicroseconds_.exchange(0));
+}
+
+
+
+//calls body(runBegin, runEnd) for each maximal run of [begin, end) in which
+//isDirty holds, so that the batch kernels still see contiguous arrays
+template <typename Predicate, typename Body>
+std::size_t SlotAnimator::forEachDirtyRun(std::size_t begin, std::size_t end,
+                                        const Predicate& isDirty,
+                                        const Body& body)
+{
+    std::size_t nDirty = 0;
+    std::size_t j = begin;
+    while (j < end)
+    {
+        if (!isDirty(j))
+        {
+            j++;
+            continue;
+        }
+
+        std::size_t runEnd = j + 1;
+        while (runEnd < end && isDirty(runEnd))
+            runEnd++;
+
+        body(j, runEnd);
+        nDirty += runEnd - j;
+        j = runEnd;
+    }
+
+    return nDirty;
+}
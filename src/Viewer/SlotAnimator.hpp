@@ -0,0 +1,114 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+#ifndef SLOT_ANIMATOR
+#define SLOT_ANIMATOR
+
+/**
+    A SlotAnimator is the CPU half of animating a slot, and needs no OpenGL
+    context. It lays the played snapshots end to end on a timeline, measured
+    in steps of the original trajectory, and maps each playback time onto
+    the pair of snapshots on either side of it. animateAtoms() interpolates
+    the atoms between those two and writes new matrices for the ones that
+    moved into their InstanceStores. animateBonds() then does the same for
+    the bonds of moved atoms, blending cached keyframes when it has them and
+    asking for those of the segments ahead. Both split their work into
+    chunks over the ThreadPool. SlotViewer owns one and draws what it
+    publishes. Once warmed up, a frame makes no heap allocations.
+**/
+
+#include "Trajectory/Trajectory.hpp"
+#include "Modeling/InstanceStore.hpp"
+#include "KeyframeCache.hpp"
+#include <atomic>
+
+class SlotAnimator
+{
+    public:
+        SlotAnimator(const TrajectoryPtr& trajectory,
+                     const std::vector<int>& playbackOrder,
+                     const glm::vec3& offsetVector, bool cycleSnapshots);
+        void addAtom(InstanceStore& store, std::size_t instance, float scale);
+        void setBonds(InstanceStore& store, float scale);
+        void setKeyframes(const KeyframeCachePtr& keyframes, int prefetchDepth);
+
+        bool animate(double time); //returns true if there was animation
+        int updateSnapshotIndexes(double time);
+        const std::vector<glm::vec3>& animateAtoms(int b);
+        void animateBonds(const std::vector<glm::vec3>& atomPositions, int b);
+        int getSnapshotA();
+        int getSnapshotB();
+        std::pair<std::size_t, std::size_t> takeInstanceCounts();
+        std::pair<std::size_t, std::size_t> takeKeyframeStalls();
+
+    public:
+        const int ANIMATION_SPEED = 2000; //steps between two snapshots
+        const std::size_t ANIMATION_CHUNK = 1024; //atoms or bonds per task
+        const float MOVEMENT_TOLERANCE = 0.001f; //smaller moves are skipped
+
+    private:
+        void buildTimeline();
+        void prefetchKeyframes();
+
+        template <typename Predicate, typename Body>
+        std::size_t forEachDirtyRun(std::size_t begin, std::size_t end,
+                                    const Predicate& isDirty, const Body& body);
+
+    private:
+        TrajectoryPtr trajectory_;
+        std::vector<int> playbackOrder_; //snapshots to visit, in order
+        glm::vec3 offsetVector_;
+        bool cycleSnapshots_; //bounce back at the end instead of restarting
+
+        std::vector<std::pair<InstanceStore*, std::size_t>> atomInstances_;
+        std::vector<InstanceStore*> atomStores_; //each published once a frame
+        std::vector<float> atomScales_;
+        std::vector<glm::mat4> atomMatrices_; //scratch space for animateAtoms
+        InstanceStore* bondStore_; //null until setBonds()
+        std::vector<Bond> bonds_;
+        float bondScale_;
+        std::vector<glm::mat4> bondMatrices_; //scratch space for animateBonds
+        KeyframeCachePtr keyframes_; //optional
+        int prefetchDepth_; //segments of keyframes ahead of playback
+
+        std::vector<glm::vec3> atomPositions_; //as of the last animateAtoms
+        std::vector<glm::vec3> lastPositions_; //when the matrices were made
+        std::vector<char> atomMoved_; //by more than MOVEMENT_TOLERANCE
+
+        std::vector<int> segmentStarts_; //in steps, one more than segments
+        std::vector<int> stepSegments_; //the segment playing at each step
+        int snapshotIndexA_, snapshotIndexB_; //interpolate between these
+                                              //positions in playbackOrder_
+        int timelineSegment_; //counts up through both directions of a bounce
+        int cursorDirection_; //1 when playing forward, -1 in reverse
+        double lastTime_; //playback time of the last updateSnapshotIndexes()
+
+        std::atomic<std::size_t> instancesUpdated_, instancesSkipped_; //FPS line
+        std::atomic<std::size_t> keyframeMisses_, stallMicroseconds_; //FPS line
+};
+
+typedef std::shared_ptr<SlotAnimator> SlotAnimatorPtr;
+
+#endif
@@ -26,10 +26,20 @@
 #define _GLIBCXX_USE_NANOSLEEP
 
 #include "SlotViewer.hpp"
+#include "InstanceTransforms.hpp"
 #include "Modeling/Shading/ShaderManager.hpp"
 #include "Trajectory/ProteinAnalysis.hpp"
+#include "Trajectory/ConformationClustering.hpp"
+#include "Trajectory/ContactMap.hpp"
+#include "Trajectory/SecondaryStructure.hpp"
+#include "Threading/ThreadPool.hpp"
 #include "Options.hpp"
 #include <algorithm>
+#include <map>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
 #include <thread>
 #include <iostream>
 
@@ -40,7 +50,8 @@ SlotViewer::SlotViewer(const TrajectoryPtr& trajectory,
     ATOM_STACKS(Options::getInstance().getAtomStacks()),
     ATOM_SLICES(Options::getInstance().getAtomSlices()),
     scene_(scene), trajectory_(trajectory), offsetVector_(offsetVector),
-    snapshotIndexA_(0), snapshotIndexB_(1)
+    impostors_(false), levelsOfDetail_(false), keyframesPrecomputed_(false),
+    foldingMeasured_(false)
 {
     std::cout << std::endl;
 
@@ -50,15 +61,55 @@ SlotViewer::SlotViewer(const TrajectoryPtr& trajectory,
         std::cout << "Creating viewer for trajectory with " <<
             trajectory_->countSnapshots() << " snapshots..." << std::endl;
 
+    choosePlaybackOrder();
+    animator_ = std::make_shared<SlotAnimator>(trajectory_, playbackOrder_,
+        offsetVector_, Options::getInstance().cycleSnapshots());
+
     const auto RENDER_MODE = Options::getInstance().getRenderMode();
-    if (RENDER_MODE == Options::RenderMode::BALL_N_STICK)
+    if (RENDER_MODE == Options::RenderMode::SURFACE)
     {
-        addAllAtoms();
+        addSurface();
         std::cout << std::endl;
     }
+    else
+    {
+        if (Options::getInstance().interpolateOnGPU())
+            uploadSnapshots();
 
-    addAllBonds();
-    std::cout << std::endl;
+        if (Options::getInstance().useImpostors())
+        {
+            if (snapshotTexture_) //both want to place the vertices
+                std::cerr << "Impostors are not available while " <<
+                    "interpolating on the GPU, using meshes instead." << std::endl;
+            else
+                impostors_ = true;
+        }
+
+        if (Options::getInstance().useLevelsOfDetail() && !impostors_)
+        {
+            if (snapshotTexture_) //the levels are sorted by CPU-side positions
+                std::cerr << "Levels of detail are not available while " <<
+                    "interpolating on the GPU, using one mesh instead." << std::endl;
+            else
+                levelsOfDetail_ = true;
+        }
+
+        if (RENDER_MODE == Options::RenderMode::BALL_N_STICK)
+        {
+            addAllAtoms();
+            std::cout << std::endl;
+        }
+
+        addAllBonds();
+        std::cout << std::endl;
+
+        if (!snapshotTexture_)
+            cacheKeyframes();
+    }
+
+    measureFoldingProgress();
+    if (Options::getInstance().highVerbosity())
+        reportSecondaryStructure();
 
     /*std::thread thread( [&] {
         ProteinAnalysis proteinAnalysis(trajectory_);
@@ -79,35 +130,46 @@ void SlotViewer::addAllAtoms()
         << " atoms." << std::endl;
     std::cout << "Adding Atoms to Scene..." << std::endl;
 
-    auto snapshotZero = trajectory_->getSnapshot(0);
-    typedef std::pair<std::size_t, InstancedModelPtr> Instance;
-    std::unordered_map<char, Instance> elementMap;
+    auto snapshotZero = trajectory_->getSnapshot(playbackOrder_[0]);
+    std::unordered_map<char, InstancedModelPtr> elementMap;
     elementMap.reserve(8);
     for (std::size_t j = 0; j < ATOMS.size(); j++)
     {
         auto atom = ATOMS[j];
-        auto matrix = generateAtomMatrix(
-                            snapshotZero->getPosition(j) + offsetVector_, atom);
+        //the GPU adds the position itself, if it is doing the interpolation
+        auto matrix = snapshotTexture_ ?
+            generateAtomMatrix(glm::vec3(0), atom) :
+            generateAtomMatrix(snapshotZero->getPosition(j) + offsetVector_, atom);
         auto element = atom->getElement();
 
+        InstancedModelPtr model;
         if (elementMap.find(element) == elementMap.end()) //not in cache
         {
             std::cout << "Generating model type " << element << "..." << std::endl;
 
-            auto model = generateAtomModel(atom, matrix);
-            elementMap[element] = std::make_pair(atomInstances_.size(), model);
-            atomInstances_.push_back(std::make_pair(model, 0));
+            model = generateAtomModel(atom, matrix);
+            elementMap[element] = model;
+            if (!snapshotTexture_ && !Options::getInstance().cullingDisabled())
+            {
+                model->cullAgainst(scene_->getCamera(), glm::vec3(0), 1);
+                model->setOccluder(true); //bonds are too thin to hide much
+            }
             scene_->addModel(model);
 
             std::cout << "... done generating data for " << element << std::endl;
         }
         else //already in cache
         {
-            auto model = elementMap[element].second;
-            atomInstances_.push_back(std::make_pair(
-                model, model->getInstanceCount()));
+            model = elementMap[element];
             model->addInstance(matrix);
         }
+
+        auto instance = model->getInstanceCount() - 1;
+        if (snapshotTexture_)
+            model->setInstanceData(instance, glm::vec4(j, 0, 0, 0));
+        else
+            animator_->addAtom(model->getModelMatrices(), instance,
+                               getAtomScale(atom));
     }
 
     std::cout << "... done adding atoms for that trajectory." << std::endl;
@@ -115,6 +177,31 @@ void SlotViewer::addAllAtoms()
 
 
 
+void SlotViewer::uploadSnapshots()
+{
+    const auto N_ATOMS = trajectory_->getTopology()->getAtoms().size();
+    const auto N_SNAPSHOTS = (std::size_t)trajectory_->countSnapshots();
+    if (!SnapshotTexture::isSupported(N_ATOMS * N_SNAPSHOTS))
+    {
+        std::cerr << "Float vertex textures are unavailable or too small, " <<
+            "interpolating on the CPU instead." << std::endl;
+        return;
+    }
+
+    std::vector<glm::vec3> positions;
+    positions.reserve(N_ATOMS * N_SNAPSHOTS);
+    for (std::size_t j = 0; j < N_SNAPSHOTS; j++)
+    {
+        auto snapshot = trajectory_->getSnapshot((int)j);
+        for (std::size_t k = 0; k < N_ATOMS; k++)
+            positions.push_back(snapshot->getPosition(k) + offsetVector_);
+    }
+
+    snapshotTexture_ = std::make_shared<SnapshotTexture>(N_ATOMS, positions);
+}
+
+
+
 void SlotViewer::addAllBonds()
 {
     const auto BONDS = trajectory_->getTopology()->getBonds();
@@ -123,131 +210,267 @@ void SlotViewer::addAllBonds()
         << " bonds." << std::endl;
     std::cout << "Adding Bonds to Scene..." << std::endl;
 
-    BufferList list = { std::make_shared<ColorBuffer>(BOND_COLOR, 6) };
-    bondInstance_ = std::make_shared<InstancedModel>(getBondMesh(), list);
+    if (impostors_)
+    {
+        BufferList list = { std::make_shared<CylinderImpostor>(BOND_COLOR) };
+        bondInstance_ = std::make_shared<InstancedModel>(getImpostorMesh(), list);
+    }
+    else if (levelsOfDetail_)
+        bondInstance_ = std::make_shared<LodModel>(generateBondLevels(),
+            scene_->getCamera());
+    else
+    {
+        BufferList list = { std::make_shared<ColorBuffer>(BOND_COLOR, 6) };
+        if (snapshotTexture_)
+            list.push_back(std::make_shared<SnapshotPlacement>(snapshotTexture_,
+                SnapshotPlacement::Target::BONDS));
+        bondInstance_ = std::make_shared<InstancedModel>(getBondMesh(), list);
+    }
 
-    auto snapshotZero = trajectory_->getSnapshot(0);
-    for (auto bond : BONDS)
+    auto snapshotZero = trajectory_->getSnapshot(playbackOrder_[0]);
+    for (std::size_t j = 0; j < BONDS.size(); j++)
     {
-        auto positionA = snapshotZero->getPosition(bond.first) + offsetVector_;
-        auto positionB = snapshotZero->getPosition(bond.second) + offsetVector_;
+        if (snapshotTexture_)
+        { //the GPU places the bond between its atoms, only the width is fixed
+            bondInstance_->addInstance(glm::scale(glm::mat4(),
+                                       glm::vec3(BOND_SCALE, BOND_SCALE, 1)));
+            bondInstance_->setInstanceData(j,
+                glm::vec4(BONDS[j].first, BONDS[j].second, 0, 0));
+            continue;
+        }
+
+        auto positionA = snapshotZero->getPosition(BONDS[j].first) + offsetVector_;
+        auto positionB = snapshotZero->getPosition(BONDS[j].second) + offsetVector_;
         bondInstance_->addInstance(generateBondMatrix(positionA, positionB));
     }
 
+    //a sphere around the middle that reaches the corners of getBondMesh()
+    if (!snapshotTexture_ && !Options::getInstance().cullingDisabled())
+        bondInstance_->cullAgainst(scene_->getCamera(), glm::vec3(0, 0, 0.5f), 1);
+
+    if (!snapshotTexture_)
+        animator_->setBonds(bondInstance_->getModelMatrices(), BOND_SCALE);
+
     scene_->addModel(bondInstance_);
     std::cout << "... done adding bonds for that trajectory." << std::endl;
 }
 
 
 
-bool SlotViewer::animate(int deltaTime)
+void SlotViewer::cacheKeyframes()
 {
-    if (trajectory_->countSnapshots() <= 1)
-        return false; //can't animate with one snapshot
+    const auto BUDGET = Options::getInstance().getKeyframeCacheSize();
+    if (BUDGET == 0 || trajectory_->getTopology()->getBonds().empty())
+        return;
 
-    if (atomInstances_.size() == 0 && bondInstance_->getInstanceCount() == 0)
-        return false; //we have nothing to animate
+    keyframes_ = std::make_shared<KeyframeCache>(trajectory_, BUDGET);
 
-    int b = updateSnapshotIndexes(deltaTime);
-    auto newPositions = animateAtoms(b);
-    animateBonds(newPositions);
+    //the current pair and those ahead of it must fit without evicting either
+    int spare = (int)keyframes_->getCapacity() - 3;
+    animator_->setKeyframes(keyframes_,
+        std::max(0, std::min(PREFETCH_DEPTH, spare)));
 
-    return true;
+    ThreadPool::getInstance().enqueue([this]()
+    {
+        keyframes_->precompute(playbackOrder_);
+        keyframesPrecomputed_ = true; //the FPS line reports the result
+    });
 }
 
 
 
-int SlotViewer::updateSnapshotIndexes(int deltaTime)
+void SlotViewer::addSurface()
 {
-    transitionTime_ += deltaTime;
+    const auto ATOMS = trajectory_->getTopology()->getAtoms();
+    std::cout << "Building molecular surface for " << ATOMS.size() <<
+        " atoms..." << std::endl;
 
-    int a = transitionTime_ / ANIMATION_SPEED; //int division on purpose
-    int b = transitionTime_ % ANIMATION_SPEED;
-    transitionTime_ = b;
+    std::vector<float> radii;
+    std::vector<glm::vec3> colors, positions;
+    auto snapshotZero = trajectory_->getSnapshot(playbackOrder_[0]);
+    for (std::size_t j = 0; j < ATOMS.size(); j++)
+    {
+        radii.push_back(ATOMS[j]->getRadius());
+        colors.push_back(ATOMS[j]->getColor());
+        positions.push_back(snapshotZero->getPosition(j) + offsetVector_);
+    }
 
-    int snapshotCount = trajectory_->countSnapshots();
-    if (snapshotCount > 2 && a > 0)
+    auto box = trajectory_->calculateBoundingBox();
+    auto surface = std::make_shared<GaussianSurface>(radii, colors,
+        box->getMinimum() + offsetVector_, box->getMaximum() + offsetVector_);
+
+    surface_ = std::make_shared<SurfaceModel>(surface, positions);
+    scene_->addModel(surface_);
+
+    std::cout << "... done, " << surface->countTriangles() << " triangles in " <<
+        surface->countBricks() << " bricks." << std::endl;
+}
+
+
+
+//the Viewer shows the result in the window title once the pool finishes it
+void SlotViewer::measureFoldingProgress()
+{
+    ThreadPool::getInstance().enqueue([this]()
     {
-        if (Options::getInstance().cycleSnapshots())
-        { //FAHViewer-like bouncing animation
-            if (snapshotIndexA_ < snapshotIndexB_)
-            { //going forward
-                snapshotIndexA_ = snapshotIndexA_ + a;
-                snapshotIndexB_ = snapshotIndexA_ + 1;
-                if (snapshotIndexB_ == snapshotCount)
-                    snapshotIndexB_ -= 2;
-            }
-            else
-            { //going backwards
-                snapshotIndexA_ = snapshotIndexA_ - a;
-                snapshotIndexB_ = snapshotIndexA_ - 1;
-                if (snapshotIndexB_ == -1)
-                    snapshotIndexB_ += 2;
-            }
-        }
-        else
-        { //default jump-to-first-snapshot animation
-            snapshotIndexA_ = (snapshotIndexA_ + a) % (snapshotCount - 1);
-            snapshotIndexB_ = snapshotIndexA_ + 1;
+        ContactMap contactMap(trajectory_, ContactMap::Resolution::RESIDUES,
+                              CONTACT_CUTOFF);
+        if (contactMap.countElements() == 0)
+            return; //not a protein
+
+        contactMap.calculateAll();
+        int final = (int)contactMap.countMaps() - 1;
+        if (final == 0)
+            return; //only the native state itself
+
+        //the final snapshot is the native state, so its own Q is always one
+        float minimum = 1, maximum = 0;
+        for (int j = 0; j < final; j++)
+        {
+            float fraction = contactMap.getNativeContactFraction(j);
+            minimum = std::min(minimum, fraction);
+            maximum = std::max(maximum, fraction);
         }
-    }
 
-    return b;
+        std::stringstream stream("");
+        stream << std::fixed << std::setprecision(2) << "Q " <<
+            contactMap.getNativeContactFraction(0) << " at first, " <<
+            minimum << "-" << maximum << " before the final snapshot";
+        foldingProgress_ = stream.str();
+        foldingMeasured_ = true;
+    });
 }
 
 
 
-std::vector<glm::vec3> SlotViewer::animateAtoms(int b)
+void SlotViewer::reportSecondaryStructure()
 {
-    auto snapA = trajectory_->getSnapshot(snapshotIndexA_);
-    auto snapB = trajectory_->getSnapshot(snapshotIndexB_);
+    SecondaryStructure structure(trajectory_);
+    if (structure.getBackbone().countResidues() == 0)
+        return; //not a protein
+
+    structure.analyzeAll();
 
-    const auto atoms = trajectory_->getTopology()->getAtoms();
-    std::vector<glm::vec3> newPositions;
-    newPositions.reserve(atoms.size());
+    typedef SecondaryStructure::Structure Structure;
+    const Structure STRUCTURES[] = { Structure::HELIX, Structure::STRAND };
+    const char* NAMES[] = { "helix", "strand" };
+    int final = trajectory_->countSnapshots() - 1;
 
-    for (std::size_t j = 0; j < atoms.size(); j++)
+    std::stringstream stream("");
+    stream << std::fixed << std::setprecision(0);
+    for (std::size_t j = 0; j < 2; j++)
     {
-        auto startPosition = snapA->getPosition(j);
-        auto endPosition   = snapB->getPosition(j);
-        auto position = (endPosition - startPosition) *
-                                   (b / (float)ANIMATION_SPEED) + startPosition;
-        position += offsetVector_;
-
-        newPositions.push_back(position);
-        if (!atomInstances_.empty())
+        float minimum = 1, maximum = 0;
+        for (int k = 0; k <= final; k++)
         {
-            auto instance = atomInstances_[j];
-            instance.first->setModelMatrix(
-                instance.second, generateAtomMatrix(position, atoms[j]));
+            float fraction = structure.getFraction(k, STRUCTURES[j]);
+            minimum = std::min(minimum, fraction);
+            maximum = std::max(maximum, fraction);
         }
+
+        stream << NAMES[j] << " " << minimum * 100 << "-" << maximum * 100 <<
+            "% (final " << structure.getFraction(final, STRUCTURES[j]) * 100 <<
+            "%) ";
     }
 
-    return newPositions;
+    std::cout << "Secondary structure: " << stream.str() << std::endl;
+    std::cout << "Final snapshot: " << structure.toString(final) << std::endl;
 }
 
 
 
-void SlotViewer::animateBonds(const std::vector<glm::vec3>& atomPositions)
+void SlotViewer::choosePlaybackOrder()
 {
-    const auto bonds = trajectory_->getTopology()->getBonds();
-    for (std::size_t j = 0; j < bonds.size(); j++)
+    const float CUTOFF = Options::getInstance().getClusterCutoff();
+    if (CUTOFF > 0 && trajectory_->countSnapshots() > 2)
     {
-        auto positionA = atomPositions[bonds[j].first];
-        auto positionB = atomPositions[bonds[j].second];
-        bondInstance_->setModelMatrix(j, generateBondMatrix(positionA, positionB));
+        std::cout << "Clustering snapshots by RMSD..." << std::endl;
+        ConformationClustering clustering(trajectory_, CUTOFF);
+        playbackOrder_ = clustering.getRepresentatives();
+        std::cout << "... done, playing " << playbackOrder_.size() <<
+            " representative snapshots." << std::endl;
+    }
+    else
+    {
+        for (int j = 0; j < trajectory_->countSnapshots(); j++)
+            playbackOrder_.push_back(j);
     }
 }
 
 
 
-std::shared_ptr<ColorBuffer> SlotViewer::generateColorBuffer(const AtomPtr& atom)
+//the CPU half is left to the SlotAnimator, unless the GPU interpolates
+bool SlotViewer::animate(double time)
 {
-    static auto N_VERTICES = (ATOM_STACKS + 1) * ATOM_SLICES;
-    std::vector<glm::vec3> colors(N_VERTICES, atom->getColor());
+    if (playbackOrder_.size() <= 1)
+        return false; //can't animate with one snapshot
 
-    auto vertices = getAtomMesh()->getVertices();
-    for (std::size_t j = 0; j < N_VERTICES; j++)
+    if (surface_)
+    {
+        surface_->update(animator_->animateAtoms(
+            animator_->updateSnapshotIndexes(time)));
+        return true;
+    }
+
+    if (snapshotTexture_)
+    { //the vertex shaders place both atoms and bonds
+        int b = animator_->updateSnapshotIndexes(time);
+        snapshotTexture_->setInterpolation(animator_->getSnapshotA(),
+            animator_->getSnapshotB(), b / (float)animator_->ANIMATION_SPEED);
+        return true;
+    }
+
+    return animator_->animate(time);
+}
+
+
+
+//returns how many instances were updated and skipped since the last call
+std::pair<std::size_t, std::size_t> SlotViewer::takeInstanceCounts()
+{
+    return animator_->takeInstanceCounts();
+}
+
+
+
+//returns how many frames missed a keyframe, and the microseconds they lost,
+//since the last call
+std::pair<std::size_t, std::size_t> SlotViewer::takeKeyframeStalls()
+{
+    return animator_->takeKeyframeStalls();
+}
+
+
+
+//returns how many keyframes precompute() cached and their size in KB, once
+//it has finished, and zeros at any other time
+std::pair<std::size_t, std::size_t> SlotViewer::takePrecomputedKeyframes()
+{
+    if (!keyframesPrecomputed_.exchange(false))
+        return std::make_pair(0, 0);
+    return std::make_pair(keyframes_->countKeyframes(),
+                          keyframes_->getMemoryUsage() / 1024);
+}
+
+
+
+//empty until the folding progress has been measured, and then only once
+std::string SlotViewer::takeFoldingProgress()
+{
+    if (!foldingMeasured_.exchange(false))
+        return "";
+    return foldingProgress_;
+}
+
+
+
+std::shared_ptr<ColorBuffer> SlotViewer::generateColorBuffer(const AtomPtr& atom,
+                                        const std::shared_ptr<Mesh>& mesh)
+{
+    auto vertices = mesh->getVertices();
+    std::vector<glm::vec3> colors(vertices.size(), atom->getColor());
+
+    for (std::size_t j = 0; j < vertices.size(); j++)
     {
         float distance = getMagnitude(vertices[j] - ATOM_LIGHT_POSITION);
         float scaledDistance = distance / ATOM_LIGHT_POWER;
@@ -262,6 +485,45 @@ std::shared_ptr<ColorBuffer> SlotViewer::generateColorBuffer(const AtomPtr& atom
 
 
 
+//the configured sphere up close, then whichever icospheres are coarser
+std::vector<LodModel::Level> SlotViewer::generateAtomLevels(const AtomPtr& atom)
+{
+    auto sphere = getAtomMesh();
+    std::vector<LodModel::Level> levels = {
+        { sphere, { generateColorBuffer(atom, sphere) }, 0 }
+    };
+
+    for (int j = 3; j >= 0; j--)
+    {
+        auto icosphere = getIcosphereMesh((unsigned int)j);
+        if (icosphere->countTriangles() >= levels.back().mesh->countTriangles())
+            continue;
+
+        levels.back().minScreenRadius = ICOSPHERE_REACH[j];
+        levels.push_back({ icosphere, { generateColorBuffer(atom, icosphere) },
+            0 });
+    }
+
+    return levels;
+}
+
+
+
+std::vector<LodModel::Level> SlotViewer::generateBondLevels()
+{
+    auto roundBond = getRoundBondMesh();
+    BufferList roundList = { std::make_shared<ColorBuffer>(BOND_COLOR,
+        roundBond->getVertices().size()) };
+    BufferList list = { std::make_shared<ColorBuffer>(BOND_COLOR, 6) };
+
+    return {
+        { roundBond, roundList, ROUND_BOND_RADIUS },
+        { getBondMesh(), list, 0 }
+    };
+}
+
+
+
 std::shared_ptr<Mesh> SlotViewer::getAtomMesh()
 {
     static std::shared_ptr<Mesh> mesh = nullptr;
@@ -364,50 +626,192 @@ std::shared_ptr<Mesh> SlotViewer::getBondMesh()
 
 
 
-InstancedModelPtr SlotViewer::generateAtomModel(const AtomPtr& atom,
-                                                const glm::mat4& matrix)
+//an icosahedron, with each face split into four 'subdivisions' times
+std::shared_ptr<Mesh> SlotViewer::getIcosphereMesh(unsigned int subdivisions)
 {
-    BufferList list = { generateColorBuffer(atom) };
-    return std::make_shared<InstancedModel>(getAtomMesh(), matrix, list);
+    static std::vector<std::shared_ptr<Mesh>> meshes;
+
+    if (subdivisions < meshes.size() && meshes[subdivisions])
+        return meshes[subdivisions];
+
+    std::cout << "Generating icosphere mesh... ";
+
+    const float t = 1.61803398875f; //golden ratio
+    std::vector<glm::vec3> vertices = {
+        glm::vec3(-1,  t,  0), glm::vec3( 1,  t,  0),
+        glm::vec3(-1, -t,  0), glm::vec3( 1, -t,  0),
+        glm::vec3( 0, -1,  t), glm::vec3( 0,  1,  t),
+        glm::vec3( 0, -1, -t), glm::vec3( 0,  1, -t),
+        glm::vec3( t,  0, -1), glm::vec3( t,  0,  1),
+        glm::vec3(-t,  0, -1), glm::vec3(-t,  0,  1)
+    };
+
+    for (auto& vertex : vertices)
+        vertex = glm::normalize(vertex);
+
+    std::vector<GLuint> indices = {
+        0, 11,  5,   0,  5,  1,   0,  1,  7,   0,  7, 10,   0, 10, 11,
+        1,  5,  9,   5, 11,  4,  11, 10,  2,  10,  7,  6,   7,  1,  8,
+        3,  9,  4,   3,  4,  2,   3,  2,  6,   3,  6,  8,   3,  8,  9,
+        4,  9,  5,   2,  4, 11,   6,  2, 10,   8,  6,  7,   9,  8,  1
+    };
+
+    for (unsigned int level = 0; level < subdivisions; level++)
+    {
+        //edges are shared by two faces, so their midpoints are too
+        std::map<std::pair<GLuint, GLuint>, GLuint> midpoints;
+        auto getMidpoint = [&](GLuint a, GLuint b)
+        {
+            auto edge = std::make_pair(std::min(a, b), std::max(a, b));
+            auto found = midpoints.find(edge);
+            if (found != midpoints.end())
+                return found->second;
+
+            vertices.push_back(glm::normalize(vertices[a] + vertices[b]));
+            midpoints[edge] = (GLuint)vertices.size() - 1;
+            return midpoints[edge];
+        };
+
+        std::vector<GLuint> split;
+        for (std::size_t j = 0; j < indices.size(); j += 3)
+        {
+            GLuint a = indices[j], b = indices[j + 1], c = indices[j + 2];
+            GLuint ab = getMidpoint(a, b);
+            GLuint bc = getMidpoint(b, c);
+            GLuint ca = getMidpoint(c, a);
+
+            split.insert(split.end(), {
+                a, ab, ca,   b, bc, ab,   c, ca, bc,   ab, bc, ca
+            });
+        }
+
+        indices.swap(split);
+    }
+
+    auto vBuffer = std::make_shared<VertexBuffer>(vertices);
+    auto iBuffer = std::make_shared<IndexBuffer>(indices, GL_TRIANGLES);
+    auto mesh = std::make_shared<Mesh>(vBuffer, iBuffer, GL_TRIANGLES);
+
+    if (meshes.size() <= subdivisions)
+        meshes.resize(subdivisions + 1);
+    meshes[subdivisions] = mesh;
+
+    std::cout << "done. Cached the result." << std::endl;
+    return mesh;
 }
 
 
 
-glm::mat4 SlotViewer::generateAtomMatrix(const glm::vec3& position,
-                                         const AtomPtr& atom)
+//an open prism as wide as getBondMesh's, but centered and rounder
+std::shared_ptr<Mesh> SlotViewer::getRoundBondMesh()
+{
+    static std::shared_ptr<Mesh> mesh = nullptr;
+
+    if (mesh)
+        return mesh;
+
+    std::cout << "Generating round bond mesh... ";
+
+    std::vector<glm::vec3> vertices;
+    for (unsigned int end = 0; end <= 1; end++)
+    {
+        for (unsigned int side = 0; side < ROUND_BOND_SIDES; side++)
+        {
+            float phi = side * 2 * PI / ROUND_BOND_SIDES;
+            vertices.push_back(glm::vec3(
+                0.5f * std::cos(phi),
+                0.5f * std::sin(phi),
+                end
+            ));
+        }
+    }
+
+    //alternates between the far and near end, winding outward
+    std::vector<GLuint> indices;
+    for (unsigned int side = 0; side <= ROUND_BOND_SIDES; side++)
+    {
+        indices.push_back(ROUND_BOND_SIDES + side % ROUND_BOND_SIDES);
+        indices.push_back(side % ROUND_BOND_SIDES);
+    }
+
+    auto vBuffer = std::make_shared<VertexBuffer>(vertices);
+    auto iBuffer = std::make_shared<IndexBuffer>(indices, GL_TRIANGLE_STRIP);
+    mesh = std::make_shared<Mesh>(vBuffer, iBuffer, GL_TRIANGLE_STRIP);
+
+    std::cout << "done. Cached the result." << std::endl;
+    return mesh;
+}
+
+
+
+//a square for impostors to ray-cast on, see SphereImpostor and CylinderImpostor
+std::shared_ptr<Mesh> SlotViewer::getImpostorMesh()
 {
-    auto matrix = glm::translate(glm::mat4(), position);
-    auto shellCount = glm::vec3(atom->getElectronShellCount());
-    return glm::scale(matrix, glm::vec3(ATOM_SCALE) * shellCount);
+    static std::shared_ptr<Mesh> mesh = nullptr;
+
+    if (mesh)
+        return mesh;
+
+    std::vector<glm::vec3> vertices = {
+        glm::vec3(-1, -1, 0),
+        glm::vec3( 1, -1, 0),
+        glm::vec3(-1,  1, 0),
+        glm::vec3( 1,  1, 0)
+    };
+
+    std::vector<GLuint> indices = { 0, 1, 2, 3 };
+
+    auto vBuffer = std::make_shared<VertexBuffer>(vertices);
+    auto iBuffer = std::make_shared<IndexBuffer>(indices, GL_TRIANGLE_STRIP);
+    mesh = std::make_shared<Mesh>(vBuffer, iBuffer, GL_TRIANGLE_STRIP);
+    return mesh;
 }
 
 
 
-glm::mat4 SlotViewer::generateBondMatrix(const glm::vec3& startPosition,
-                                         const glm::vec3& endPosition
-)
+InstancedModelPtr SlotViewer::generateAtomModel(const AtomPtr& atom,
+                                                const glm::mat4& matrix)
 {
-    float distance = getMagnitude(startPosition - endPosition);
-    if (distance <= FLT_EPSILON)
-        return glm::scale(glm::mat4(), glm::vec3(glm::vec2(BOND_SCALE), FLT_EPSILON));
+    if (impostors_)
+    {
+        BufferList list = { std::make_shared<SphereImpostor>(atom->getColor(),
+            ATOM_LIGHT_POSITION, ATOM_LIGHT_POWER, ATOM_LIGHT_COLOR) };
+        return std::make_shared<InstancedModel>(getImpostorMesh(), matrix, list);
+    }
+
+    if (levelsOfDetail_)
+        return std::make_shared<LodModel>(generateAtomLevels(atom),
+            scene_->getCamera(), matrix);
+
+    BufferList list = { generateColorBuffer(atom, getAtomMesh()) };
+    if (snapshotTexture_)
+        list.push_back(std::make_shared<SnapshotPlacement>(snapshotTexture_,
+            SnapshotPlacement::Target::ATOMS));
+    return std::make_shared<InstancedModel>(getAtomMesh(), matrix, list);
+}
+
+
 
-    auto matrix = alignBetween(startPosition, endPosition);
-    return glm::scale(matrix, glm::vec3(glm::vec2(BOND_SCALE), distance));
+float SlotViewer::getAtomScale(const AtomPtr& atom)
+{
+    return ATOM_SCALE * atom->getElectronShellCount();
 }
 
 
 
-glm::mat4 SlotViewer::alignBetween(const glm::vec3& ptA, const glm::vec3& ptB)
-{ //adapted from http://www.thjsmith.com/40/cylinder-between-two-points-opengl-c
+glm::mat4 SlotViewer::generateAtomMatrix(const glm::vec3& position,
+                                         const AtomPtr& atom)
+{
+    return InstanceTransforms::atomMatrix(position, getAtomScale(atom));
+}
 
-    glm::vec3 z(0, 0, 1);
-    glm::vec3 p = ptB - ptA;
 
-    float radians = (float)std::acos(getDotProduct(z, p) / getMagnitude(p));
-    float angle = 180 / 3.1415926f * radians;
 
-    auto translated = glm::translate(glm::mat4(), ptA);
-    return glm::rotate(translated, (float)angle, glm::cross(z, p));
+glm::mat4 SlotViewer::generateBondMatrix(const glm::vec3& startPosition,
+                                         const glm::vec3& endPosition
+)
+{
+    return InstanceTransforms::bondMatrix(startPosition, endPosition, BOND_SCALE);
 }
 
 
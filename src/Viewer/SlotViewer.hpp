@@ -27,17 +27,30 @@
 #define SLOT_VIEWER
 
 /*
-    SlotViewer handles the viewing of the protein from a particular slot.
-    It is given the Trajectory for that slot, and then adds atoms and bonds
+    SlotViewer handles the viewing of the protein from a particular slot. It
+    is given the Trajectory for that slot, and then adds atoms and bonds
     Models to the Scene. The update function animates them by interpolating
-    between the available checkpoints. The animation jumps to the first
-    checkpoint when it reaches the final one. This is in contrast to FAHViewer,
-    which runs the animation backwards.
+    between the available checkpoints, or in surface mode, a single molecular
+    surface that is re-meshed as they move. The animation jumps to the first
+    checkpoint when it reaches the final one. This is in contrast to
+    FAHViewer, which runs the animation backwards. Each frame reads its place
+    in the animation from the shared Playback clock, and a SlotAnimator does
+    the CPU side of placing the atoms and bonds there. If requested, the
+    snapshots are first clustered by RMSD, and only one representative of each
+    cluster is played.
 */
 
 #include "Trajectory/Trajectory.hpp"
+#include "SlotAnimator.hpp"
+#include "KeyframeCache.hpp"
 #include "World/Scene.hpp"
+#include "Modeling/SurfaceModel.hpp"
+#include "Modeling/LodModel.hpp"
+#include "Modeling/DataBuffers/SnapshotPlacement.hpp"
 #include "Modeling/DataBuffers/ColorBuffer.hpp"
+#include "Modeling/DataBuffers/SphereImpostor.hpp"
+#include "Modeling/DataBuffers/CylinderImpostor.hpp"
+#include <atomic>
 
 /*
 // http://stackoverflow.com/questions/7222143/unordered-map-hash-function-c
@@ -71,18 +84,19 @@ class SlotViewer
         SlotViewer(const TrajectoryPtr& trajectory,
                    const glm::vec3& offsetVector,
                    const std::shared_ptr<Scene>& scene);
-        bool animate(int deltaTime); //returns true if there was animation
-        int updateSnapshotIndexes(int deltaTime);
-        std::vector<glm::vec3> animateAtoms(int b);
-        void animateBonds(const std::vector<glm::vec3>& atomPositions);
-        static glm::mat4 alignBetween(const glm::vec3& a, const glm::vec3& b);
+        bool animate(double time); //returns true if there was animation
+        std::pair<std::size_t, std::size_t> takeInstanceCounts();
+        std::pair<std::size_t, std::size_t> takeKeyframeStalls();
+        std::pair<std::size_t, std::size_t> takePrecomputedKeyframes();
+        std::string takeFoldingProgress();
         static float getDotProduct(const glm::vec3& vecA, const glm::vec3& vecB);
         static float getMagnitude(const glm::vec3& vector);
 
     public:
         const float ATOM_SCALE = 0.15f; //0.04 is good for getMass
+        const float CONTACT_CUTOFF = 8.0f; //between alpha carbons
         const float BOND_SCALE = 0.07f;
-        const int ANIMATION_SPEED = 2000;
+        const int PREFETCH_DEPTH = 3; //segments of keyframes ahead of playback
 
         const unsigned int ATOM_STACKS, ATOM_SLICES;
 
@@ -91,19 +105,37 @@ class SlotViewer
         const glm::vec3 ATOM_LIGHT_COLOR = glm::vec3(4);
 
         const glm::vec3 BOND_COLOR = glm::vec3(0.8, 0.12, 0.5);
+
+        //largest radius on screen, in pixels, for icospheres of 20 * 4^j faces
+        const float ICOSPHERE_REACH[4] = { 3, 8, 20, 48 };
+        const float ROUND_BOND_RADIUS = 3; //pixels, when bonds become octagons
+        const unsigned int ROUND_BOND_SIDES = 8;
         const float PI = 3.141592653589f;
 
     private:
         void addAllAtoms();
         void addAllBonds();
+        void addSurface();
+        void uploadSnapshots();
+        void cacheKeyframes();
+        void measureFoldingProgress();
+        void reportSecondaryStructure();
+        void choosePlaybackOrder();
 
         std::shared_ptr<Mesh> getAtomMesh();
+        std::shared_ptr<Mesh> getIcosphereMesh(unsigned int subdivisions);
         std::shared_ptr<Mesh> getBondMesh();
+        std::shared_ptr<Mesh> getRoundBondMesh();
+        std::shared_ptr<Mesh> getImpostorMesh();
 
-        std::shared_ptr<ColorBuffer> generateColorBuffer(const AtomPtr& atom);
+        std::shared_ptr<ColorBuffer> generateColorBuffer(const AtomPtr& atom,
+                                        const std::shared_ptr<Mesh>& mesh);
+        std::vector<LodModel::Level> generateAtomLevels(const AtomPtr& atom);
+        std::vector<LodModel::Level> generateBondLevels();
         InstancedModelPtr generateAtomModel(const AtomPtr& atom,
                                             const glm::mat4& matrix);
 
+        float getAtomScale(const AtomPtr& atom);
         glm::mat4 generateAtomMatrix(const glm::vec3& position, const AtomPtr& atom);
         glm::mat4 generateBondMatrix(const glm::vec3& startPosition,
                                      const glm::vec3& endPosition);
@@ -113,11 +145,18 @@ class SlotViewer
         TrajectoryPtr trajectory_;
         glm::vec3 offsetVector_;
 
-        std::vector<std::pair<InstancedModelPtr, std::size_t>> atomInstances_;
+        SlotAnimatorPtr animator_; //places the atoms and bonds
         InstancedModelPtr bondInstance_;
-
-        int transitionTime_; //how much elapsed time between each snapshot
-        int snapshotIndexA_, snapshotIndexB_; //interpolate between these
+        KeyframeCachePtr keyframes_; //optional
+        SurfaceModelPtr surface_;
+        SnapshotTexturePtr snapshotTexture_; //if interpolating on the GPU
+        bool impostors_; //ray-cast instead of tessellated
+        bool levelsOfDetail_; //tessellated by size on screen
+        std::vector<int> playbackOrder_; //snapshots to visit, in order
+
+        std::atomic<bool> keyframesPrecomputed_; //FPS line
+        std::string foldingProgress_; //written before foldingMeasured_
+        std::atomic<bool> foldingMeasured_; //window title
 };
 
 #endif
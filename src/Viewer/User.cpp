@@ -26,6 +26,7 @@
 #include "User.hpp"
 #include "World/Camera.hpp"
 #include "Viewer/SlotViewer.hpp"
+#include "Playback.hpp"
 #include <GL/glut.h>
 #include <algorithm>
 #include <iostream>
@@ -97,6 +98,39 @@ void User::onKeyPress(unsigned char key)
         case ESCAPE:
             releasePointer();
             break;
+
+        case ' ':
+            Playback::getInstance().togglePause();
+            break;
+
+        case 'r':
+            Playback::getInstance().reverse();
+            break;
+
+        case '+':
+        case '=':
+            Playback::getInstance().changeSpeed(PLAYBACK_SPEED_FACTOR);
+            break;
+
+        case '-':
+            Playback::getInstance().changeSpeed(1 / PLAYBACK_SPEED_FACTOR);
+            break;
+
+        case ']':
+            Playback::getInstance().stepSnapshot(1);
+            break;
+
+        case '[':
+            Playback::getInstance().stepSnapshot(-1);
+            break;
+
+        case '.':
+            Playback::getInstance().scrub(Playback::getInstance().SCRUB_STEP);
+            break;
+
+        case ',':
+            Playback::getInstance().scrub(-Playback::getInstance().SCRUB_STEP);
+            break;
     }
 }
 
@@ -145,6 +179,10 @@ void User::onSpecialKeyPress(int key)
         case GLUT_KEY_PAGE_DOWN:
             downKeys_.insert(KeyAction::POSITIVE_ROLL);
             break;
+
+        case GLUT_KEY_HOME:
+            Playback::getInstance().seek(0);
+            break;
     }
 }
 
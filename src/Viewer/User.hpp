@@ -34,6 +34,7 @@
     The mouse controls the orientation of the camera, and the WASDQE keys
     control the location. The camera moves with linear acceleration and
     geometric (non-linear) deceleration, which creates smooth and fluid movement.
+    A few more keys control the Playback of the animation.
 **/
 
 #include "World/Scene.hpp"
@@ -52,6 +53,8 @@ class User
         const float YAW_COEFFICIENT = 0.05f;
         const float ROLL_SPEED = 0.05f;
 
+        const double PLAYBACK_SPEED_FACTOR = 2;
+
     public:
         User(std::shared_ptr<Scene> scene);
         void update(int deltaTime);
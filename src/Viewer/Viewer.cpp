@@ -29,11 +29,17 @@
 #include "FAHClientIO.hpp"
 #include "Sockets/SocketException.hpp"
 #include "PyON/TrajectoryParser.hpp"
+#include "Trajectory/SnapshotDecimator.hpp"
+#include "Threading/ThreadPool.hpp"
+#include "Playback.hpp"
 #include "Modeling/DataBuffers/SampledBuffers/Image.hpp"
 #include "Modeling/DataBuffers/SampledBuffers/TexturedCube.hpp"
+#include "Modeling/GLStateCache.hpp"
+#include "Modeling/Shading/ShaderManager.hpp"
 #include "Options.hpp"
 #include <thread>
 #include <algorithm>
+#include <climits>
 #include <iostream>
 
 /*
@@ -50,19 +56,122 @@
 Viewer::Viewer() :
     scene_(std::make_shared<Scene>(createCamera())),
     user_(std::make_shared<User>(scene_)),
-    timeSpentRendering_(0), frameCount_(0), needsRerendering_(true)
+    timeSpentRendering_(0), frameCount_(0), needsRerendering_(true),
+    playbackChanges_(ULONG_MAX)
 {
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_CULL_FACE);
     glCullFace(GL_BACK);
 
+    chooseInstancing();
+    chooseVertexArrays();
+    chooseUniformBuffers();
+    chooseProgramCache();
+    chooseOcclusionCulling();
     addModels();
+    ShaderManager::reportBuildTime();
     user_->grabPointer();
     reportFPS();
 }
 
 
 
+//must happen before any models are saved, as it decides how they are drawn
+void Viewer::chooseInstancing()
+{
+    if (Options::getInstance().instancingDisabled())
+        std::cout << "Hardware instancing disabled, drawing each instance " <<
+            "separately." << std::endl;
+    else if (!InstancedModel::isInstancingSupported())
+        std::cout << "Hardware instancing is not supported, drawing each " <<
+            "instance separately." << std::endl;
+    else
+    {
+        std::cout << "Drawing each model with hardware instancing." << std::endl;
+        InstancedModel::setInstancing(true);
+    }
+}
+
+
+
+//like instancing, this must be decided before any models are saved
+void Viewer::chooseVertexArrays()
+{
+    if (Options::getInstance().vertexArraysDisabled())
+        std::cout << "Vertex array objects disabled, enabling every buffer " <<
+            "on each draw." << std::endl;
+    else if (!InstancedModel::isVertexArraySupported())
+        std::cout << "Vertex array objects are not supported, enabling " <<
+            "every buffer on each draw." << std::endl;
+    else
+    {
+        std::cout << "Recording each model's buffers in a vertex array object."
+            << std::endl;
+        InstancedModel::setVertexArrays(true);
+    }
+}
+
+
+
+//must happen before any models are added, as it decides their shaders
+void Viewer::chooseUniformBuffers()
+{
+    if (Options::getInstance().uniformBuffersDisabled())
+        std::cout << "Uniform buffer objects disabled, setting the camera " <<
+            "and lights in each program." << std::endl;
+    else if (!Scene::isUniformBufferSupported())
+        std::cout << "Uniform buffer objects are not supported, setting " <<
+            "the camera and lights in each program." << std::endl;
+    else
+    {
+        std::cout << "Sharing the camera and lights between programs in " <<
+            "uniform buffers." << std::endl;
+        scene_->useUniformBuffers();
+    }
+}
+
+
+
+void Viewer::chooseProgramCache()
+{
+    auto directory = ProgramCache::getDefaultDirectory();
+    if (Options::getInstance().programCacheDisabled())
+        std::cout << "Shader program cache disabled, compiling every " <<
+            "program." << std::endl;
+    else if (!ProgramCache::isSupported())
+        std::cout << "Program binaries are not supported, compiling every " <<
+            "shader program." << std::endl;
+    else if (directory.empty())
+        std::cerr << "No cache directory, compiling every shader program."
+            << std::endl;
+    else
+    {
+        std::cout << "Caching shader programs in " << directory << std::endl;
+        ShaderManager::setProgramCache(std::make_shared<ProgramCache>(directory));
+    }
+}
+
+
+
+void Viewer::chooseOcclusionCulling()
+{
+    if (!Options::getInstance().useOcclusionCulling())
+        return;
+
+    if (Options::getInstance().cullingDisabled())
+        std::cerr << "Occlusion culling needs culling, ignoring it." << std::endl;
+    else if (!OcclusionMap::isSupported())
+        std::cerr << "Framebuffer objects are not supported, " <<
+            "drawing hidden atoms anyway." << std::endl;
+    else
+    {
+        std::cout << "Culling atoms and bonds hidden behind others." << std::endl;
+        scene_->setOcclusionMap(std::make_shared<OcclusionMap>());
+    }
+}
+
+
+
 void Viewer::reportFPS()
 {
     std::thread fpsReporter([&]()
@@ -72,10 +181,56 @@ void Viewer::reportFPS()
         {
             std::this_thread::sleep_for(std::chrono::seconds(2));
 
+            std::size_t updated = 0, skipped = 0, misses = 0, stalled = 0;
+            std::size_t keyframes = 0, keyframeKB = 0;
+            for (auto viewer : slotViewers_)
+            {
+                auto counts = viewer->takeInstanceCounts();
+                updated += counts.first;
+                skipped += counts.second;
+
+                auto stalls = viewer->takeKeyframeStalls();
+                misses += stalls.first;
+                stalled += stalls.second;
+
+                auto precomputed = viewer->takePrecomputedKeyframes();
+                keyframes += precomputed.first;
+                keyframeKB += precomputed.second;
+            }
+
+            auto drawCalls = InstancedModel::takeDrawCallCount();
+            auto triangles = InstancedModel::takeTriangleCount();
+            auto culling = InstancedModel::takeCullingCounts();
+            auto occluded = InstancedModel::takeOcclusionCount();
+            auto stateCalls = GLStateCache::getInstance().takeCallCounts();
+
             glm::vec3 cameraPos = scene_->getCamera()->getPosition();
             std::cout << frameCount_ / 2 << " FPS, spent " <<
-                timeSpentRendering_ / 2 << " ms rendering. <" << cameraPos.x <<
-                ", " << cameraPos.y << ", " << cameraPos.z << ">" << std::endl;
+                timeSpentRendering_ / 2 << " ms rendering";
+            if (frameCount_ > 0)
+                std::cout << ", " << drawCalls / frameCount_ << " draw calls, " <<
+                    triangles / frameCount_ << " triangles and " <<
+                    timeSpentRendering_ / frameCount_ << " ms per frame";
+            if (frameCount_ > 0 && culling.second > 0)
+                std::cout << ", drew " << culling.first / frameCount_ <<
+                    " and culled " << culling.second / frameCount_ << " instances";
+            if (frameCount_ > 0 && occluded > 0)
+                std::cout << " (" << occluded / frameCount_ << " hidden)";
+            if (frameCount_ > 0 && stateCalls.first + stateCalls.second > 0)
+                std::cout << ", " << stateCalls.first / frameCount_ <<
+                    " GL state calls (" << stateCalls.second / frameCount_ <<
+                    " redundant ones skipped)";
+            if (updated + skipped > 0)
+                std::cout << ", skipped " << 100 * skipped / (updated + skipped)
+                    << "% of instance updates";
+            if (misses > 0)
+                std::cout << ", " << misses << " keyframe misses cost " <<
+                    stalled / 1000.0f << " ms";
+            if (keyframes > 0)
+                std::cout << ", cached " << keyframes << " keyframes in " <<
+                    keyframeKB << " KB";
+            std::cout << ". <" << cameraPos.x << ", " << cameraPos.y << ", " <<
+                cameraPos.z << ">" << std::endl;
 
             frameCount_ = 0;
             timeSpentRendering_ = 0;
@@ -244,6 +399,14 @@ std::vector<TrajectoryPtr> Viewer::getTrajectories()
         trajectories.push_back(parser.parse());
     }
 
+    const float THRESHOLD = Options::getInstance().getDecimationThreshold();
+    if (THRESHOLD > 0)
+    {
+        SnapshotDecimator decimator(THRESHOLD);
+        for (auto& trajectory : trajectories)
+            trajectory = decimator.decimate(trajectory);
+    }
+
     return trajectories;
 }
 
@@ -341,11 +504,28 @@ void Viewer::update(int deltaTime)
 
 
 
-void Viewer::animate(int deltaTime)
+void Viewer::animate()
 {
+    //every slot is placed at the same instant, so they never fall out of step
+    const auto STATE = Playback::getInstance().getState();
+    if (STATE.paused && STATE.changes == playbackChanges_)
+        return; //the clock has not moved, so neither has anything else
+    playbackChanges_ = STATE.changes;
+
+    //slots are independent, and each one splits its atoms and bonds further;
+    //parallelFor only returns once every slot is done, so the frame is whole
+    slotAnimated_.resize(slotViewers_.size());
+    ThreadPool::getInstance().parallelFor(slotViewers_.size(), 1,
+        [&](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t j = begin; j < end; j++)
+                slotAnimated_[j] = slotViewers_[j]->animate(STATE.time);
+        }
+    );
+
     bool animationHappened = false;
-    for (auto viewer : slotViewers_)
-        if (viewer->animate(deltaTime)) //test if animation happened
+    for (auto slotAnimated : slotAnimated_)
+        if (slotAnimated) //test if animation happened
             animationHappened = true;
 
     if (animationHappened)
@@ -356,6 +536,7 @@ void Viewer::animate(int deltaTime)
 
 void Viewer::render()
 {
+    showFoldingProgress();
     if (!needsRerendering_ && !user_->isMoving())
         return;
     needsRerendering_ = false; //it was true, so reset it and then render
@@ -370,6 +551,37 @@ void Viewer::render()
 
 
 
+//the window title is on screen even when stdout is not, which it only is with
+//--verbose, so each slot's folding progress goes there once it is measured
+void Viewer::showFoldingProgress()
+{
+    foldingProgress_.resize(slotViewers_.size());
+
+    bool measured = false;
+    for (std::size_t j = 0; j < slotViewers_.size(); j++)
+    {
+        auto progress = slotViewers_[j]->takeFoldingProgress();
+        if (progress.empty())
+            continue;
+
+        std::cout << "Fraction of native contacts in slot " << j << ": " <<
+            progress << "." << std::endl;
+        foldingProgress_[j] = progress;
+        measured = true;
+    }
+
+    if (!measured)
+        return;
+
+    std::string title = "Folding Atomata";
+    for (std::size_t j = 0; j < foldingProgress_.size(); j++)
+        if (!foldingProgress_[j].empty())
+            title += " - slot " + std::to_string(j) + ": " + foldingProgress_[j];
+    glutSetWindowTitle(title.c_str());
+}
+
+
+
 void Viewer::handleWindowReshape(int newWidth, int newHeight)
 {
     scene_->getCamera()->setAspectRatio(newWidth / (float)newHeight);
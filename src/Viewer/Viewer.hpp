@@ -32,8 +32,8 @@
     it uses the FAHClientIO class to load trajectory information from FAHClient,
     constructs SlotViewers, and adds Lights and a Camera to the Scene. It also
     has an update and render method to implement a simple gameplay loop.
-    It uses the update method to ask the SlotViewers to animate or step forward
-    the amount of time since the last time the update method was called.
+    It uses the update method to move the User, and the animate method to ask
+    the SlotViewers to catch up with the current time of the Playback clock.
 **/
 
 #include "User.hpp"
@@ -45,7 +45,7 @@ class Viewer
 {
     public:
         void update(int deltaTime);
-        void animate(int deltaTime);
+        void animate();
         void render();
         void handleWindowReshape(int screenWidth, int screenHeight);
         std::shared_ptr<User> getUser();
@@ -53,7 +53,13 @@ class Viewer
 
     private:
         Viewer();
+        void chooseInstancing();
+        void chooseVertexArrays();
+        void chooseUniformBuffers();
+        void chooseProgramCache();
+        void chooseOcclusionCulling();
         void reportFPS();
+        void showFoldingProgress();
         void addModels();
         void addSkybox();
         std::vector<BoundingBoxPtr> addSlotViewers();
@@ -73,6 +79,9 @@ class Viewer
         bool needsRerendering_;
 
         std::vector<std::shared_ptr<SlotViewer>> slotViewers_;
+        std::vector<char> slotAnimated_; //by the last animate()
+        unsigned long playbackChanges_; //as of the last animate()
+        std::vector<std::string> foldingProgress_; //per slot, for the title
 };
 
 #endif
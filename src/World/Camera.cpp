@@ -92,6 +92,20 @@ void Camera::sync(GLint viewMatrixUniform, GLint projMatrixUniform)
 
 
 
+//like sync(), but into the bound uniform buffer, for every Program at once
+void Camera::syncBlock(GLintptr viewMatrixOffset, GLintptr projMatrixOffset)
+{
+    if (syncView_)
+        glBufferSubData(GL_UNIFORM_BUFFER, viewMatrixOffset, sizeof(glm::mat4),
+                                        glm::value_ptr(temporaryViewMatrix_));
+
+    if (syncProjection_)
+        glBufferSubData(GL_UNIFORM_BUFFER, projMatrixOffset, sizeof(glm::mat4),
+                                        glm::value_ptr(temporaryProjMatrix_));
+}
+
+
+
 void Camera::endSync()
 {
     syncView_ = viewUpdated_;
@@ -52,6 +52,7 @@ class Camera
         void reset();
         void startSync();
         void sync(GLint viewMatrixUniform, GLint projMatrixUniform);
+        void syncBlock(GLintptr viewMatrixOffset, GLintptr projMatrixOffset);
         void endSync();
 
         //position and orient the camera
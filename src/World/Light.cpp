@@ -30,11 +30,12 @@
 
 
 std::size_t Light::nLights_ = 0;
+bool Light::uniformBlock_ = false;
 
 
 Light::Light(const glm::vec3& position, const glm::vec3& color, float power):
     position_(position), color_(glm::normalize(color)),
-    power_(power), emitting_(true)
+    power_(power), emitting_(true), updated_(true)
 {
     nLights_++;
 }
@@ -51,6 +52,7 @@ glm::vec3 Light::getPosition() const
 void Light::setPosition(const glm::vec3& newPos)
 {
     position_ = newPos;
+    updated_ = true;
 }
 
 
@@ -65,6 +67,7 @@ glm::vec3 Light::getColor() const
 void Light::setColor(const glm::vec3& newColor)
 {
     color_ = newColor;
+    updated_ = true;
 }
 
 
@@ -79,6 +82,7 @@ float Light::getPower() const
 void Light::setPower(float power)
 {
     power_ = power;
+    updated_ = true;
 }
 
 
@@ -94,29 +98,69 @@ bool Light::isEmitting() const
 void Light::setEmitting(bool emitting)
 {
     emitting_ = emitting;
+    updated_ = true;
 }
 
 
 
-void Light::sync(GLuint handle, std::size_t lightID)
+//the uniform names are only assembled once per Program, when it is added
+Light::Locations Light::locate(GLuint handle, std::size_t lightID) const
 {
     //should look into http://stackoverflow.com/questions/8099979/glsl-c-arrays-of-uniforms
     auto lightRef = "lights[" + std::to_string(lightID) + "]";
 
-    GLint posLoc = glGetUniformLocation(handle, (lightRef + ".position").c_str());
-    glUniform3fv(posLoc, 1, glm::value_ptr(getPosition()));
+    Locations locations;
+    locations.position = glGetUniformLocation(handle, (lightRef + ".position").c_str());
+    locations.color = glGetUniformLocation(handle, (lightRef + ".color").c_str());
+    locations.power = glGetUniformLocation(handle, (lightRef + ".power").c_str());
 
-    GLint colorLoc = glGetUniformLocation(handle, (lightRef + ".color").c_str());
-    glUniform3fv(colorLoc, 1, glm::value_ptr(getColor()));
+    if (locations.position < 0 || locations.color < 0 || locations.power < 0)
+        throw std::runtime_error("Unable to find Light uniform variables!");
+
+    return locations;
+}
 
-    GLint powerLoc = glGetUniformLocation(handle, (lightRef + ".power").c_str());
-    float power = isEmitting() ? getPower() : 0;
-    glUniform1f(powerLoc, power);
 
-    //std::cout << handle << " " << lightID << " " << nLights_ << " " << posLoc << " " << colorLoc << " " << powerLoc << std::endl;
 
-    if (posLoc < 0 || colorLoc < 0 || powerLoc < 0)
-        throw std::runtime_error("Unable to find Light uniform variables!");
+void Light::sync(const Locations& locations) const
+{
+    glUniform3fv(locations.position, 1, glm::value_ptr(getPosition()));
+    glUniform3fv(locations.color, 1, glm::value_ptr(getColor()));
+    glUniform1f(locations.power, isEmitting() ? getPower() : 0);
+}
+
+
+
+Light::BlockData Light::getBlockData() const
+{
+    BlockData data;
+    data.position = getPosition();
+    data.padding = 0;
+    data.color = getColor();
+    data.power = isEmitting() ? getPower() : 0;
+    return data;
+}
+
+
+
+bool Light::isUpdated() const
+{
+    return updated_;
+}
+
+
+
+void Light::markSynced()
+{
+    updated_ = false;
+}
+
+
+
+//must be set before any shaders are assembled
+void Light::setUniformBlock(bool enabled)
+{
+    uniformBlock_ = enabled;
 }
 
 
@@ -158,8 +202,21 @@ SnippetPtr Light::getFragmentShaderGLSL()
                 vec3 position, color;
                 float power; //its maximum distance of influence
             };
+        ).";
 
+    if (uniformBlock_) //shared by all Programs, see Scene::syncUniformBuffers
+        fieldStrStream << R".(
+            layout(std140) uniform LightBlock
+            {
+                Light lights[)." << nLights_ << R".(];
+            };
+        ).";
+    else
+        fieldStrStream << R".(
             uniform Light lights[)." << nLights_ << R".(];
+        ).";
+
+    fieldStrStream << R".(
             varying vec3 fragmentPosition;
         ).";
 
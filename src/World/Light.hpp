@@ -32,11 +32,15 @@
     The power defines the maximum distance that it can illuminate before
     dissipating completely. The magnitude of the color helps define the decay
     rate (a extremely high value will appear not to dissipate at all).
+    A Light's uniforms are located once per Program, when it is linked, and
+    only set again after the Light changes. With uniform buffers, all Lights
+    live in one LightBlock shared by every Program instead.
 **/
 
 #include "Modeling/Shading/ShaderUtilizer.hpp"
 #include "glm/glm.hpp"
 #include <GL/glew.h>
+#include <vector>
 
 class Light : public ShaderUtilizer
 {
@@ -57,17 +61,38 @@ class Light : public ShaderUtilizer
         float getPower() const;
         bool isEmitting() const;
 
-        void sync(GLuint handle, std::size_t lightID);
+        struct Locations
+        {
+            GLint position, color, power;
+        };
+
+        struct BlockData //std140 layout of the GLSL Light, see LightBlock
+        {
+            glm::vec3 position;
+            float padding;
+            glm::vec3 color;
+            float power;
+        };
+
+        Locations locate(GLuint handle, std::size_t lightID) const;
+        void sync(const Locations& locations) const;
+        BlockData getBlockData() const;
+        bool isUpdated() const;
+        void markSynced();
 
         virtual SnippetPtr getVertexShaderGLSL();
         virtual SnippetPtr getFragmentShaderGLSL();
 
+        static void setUniformBlock(bool enabled);
+
     private:
         glm::vec3 position_, color_;
         float power_;
         bool emitting_;
+        bool updated_; //since the last sync
 
         static std::size_t nLights_;
+        static bool uniformBlock_;
 };
 
 typedef std::vector<std::shared_ptr<Light>> LightList;
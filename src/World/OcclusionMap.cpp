@@ -0,0 +1,201 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+#include "OcclusionMap.hpp"
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <stdexcept>
+
+
+OcclusionMap::OcclusionMap() :
+    framebuffer_(0), depthBuffer_(0), width_(0), height_(0)
+{}
+
+
+
+OcclusionMap::~OcclusionMap()
+{
+    glDeleteRenderbuffers(1, &depthBuffer_);
+    glDeleteFramebuffers(1, &framebuffer_);
+}
+
+
+
+//redirects drawing into the small depth buffer until end()
+void OcclusionMap::begin()
+{
+    glGetIntegerv(GL_VIEWPORT, viewport_);
+    int height = std::max(1, WIDTH * viewport_[3] / std::max(1, viewport_[2]));
+    if (width_ != WIDTH || height_ != height)
+        resize(WIDTH, height);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+    glViewport(0, 0, width_, height_);
+    glClear(GL_DEPTH_BUFFER_BIT);
+}
+
+
+
+void OcclusionMap::end(const glm::mat4& viewProjection)
+{
+    glReadPixels(0, 0, width_, height_, GL_DEPTH_COMPONENT, GL_FLOAT,
+        levels_.front().data());
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(viewport_[0], viewport_[1], viewport_[2], viewport_[3]);
+
+    viewProjection_ = viewProjection;
+    buildPyramid();
+}
+
+
+
+bool OcclusionMap::isOccluded(const glm::vec3& min, const glm::vec3& max) const
+{
+    if (levels_.empty())
+        return false;
+
+    glm::vec2 low(std::numeric_limits<float>::max()), high(-low);
+    float nearest = 1;
+    for (int corner = 0; corner < 8; corner++)
+    {
+        glm::vec4 clip = viewProjection_ * glm::vec4(
+            corner & 1 ? max.x : min.x,
+            corner & 2 ? max.y : min.y,
+            corner & 4 ? max.z : min.z, 1);
+        if (clip.w <= 0)
+            return false; //reaches behind the camera
+
+        glm::vec3 ndc = glm::vec3(clip) / clip.w;
+        low = glm::min(low, glm::vec2(ndc));
+        high = glm::max(high, glm::vec2(ndc));
+        nearest = std::min(nearest, ndc.z * 0.5f + 0.5f);
+    }
+
+    if (nearest < 0)
+        return false; //crosses the near plane
+
+    //covered texels of the finest level, widened by one
+    int x0 = std::max((int)std::floor((low.x  * 0.5f + 0.5f) * width_) - 1, 0);
+    int x1 = std::min((int)std::floor((high.x * 0.5f + 0.5f) * width_) + 1,
+                      width_ - 1);
+    int y0 = std::max((int)std::floor((low.y  * 0.5f + 0.5f) * height_) - 1, 0);
+    int y1 = std::min((int)std::floor((high.y * 0.5f + 0.5f) * height_) + 1,
+                      height_ - 1);
+    if (x0 > x1 || y0 > y1)
+        return false; //off screen, which is for the frustum test to decide
+
+    //climb until the box spans at most four texels each way
+    std::size_t level = 0;
+    while (level + 1 < levels_.size() && (x1 - x0 > 3 || y1 - y0 > 3))
+    {
+        x0 >>= 1; x1 >>= 1;
+        y0 >>= 1; y1 >>= 1;
+        level++;
+    }
+
+    float furthest = 0;
+    for (int y = y0; y <= y1; y++)
+        for (int x = x0; x <= x1; x++)
+            furthest = std::max(furthest,
+                levels_[level][(std::size_t)(y * sizes_[level].x + x)]);
+
+    return nearest > furthest;
+}
+
+
+
+bool OcclusionMap::isSupported()
+{
+    return GLEW_ARB_framebuffer_object;
+}
+
+
+
+void OcclusionMap::resize(int width, int height)
+{
+    width_ = width;
+    height_ = height;
+
+    if (!framebuffer_)
+    {
+        glGenFramebuffers(1, &framebuffer_);
+        glGenRenderbuffers(1, &depthBuffer_);
+    }
+
+    glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer_);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+        GL_RENDERBUFFER, depthBuffer_);
+    glDrawBuffer(GL_NONE); //depth only
+    glReadBuffer(GL_NONE);
+
+    auto status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+        throw std::runtime_error("Incomplete framebuffer for occlusion culling!");
+
+    levels_.clear();
+    sizes_.clear();
+    glm::ivec2 size(width, height);
+    while (true)
+    {
+        sizes_.push_back(size);
+        levels_.push_back(std::vector<float>((std::size_t)(size.x * size.y)));
+        if (size.x == 1 && size.y == 1)
+            break;
+        size = (size + 1) / 2;
+    }
+}
+
+
+
+//each texel takes the furthest of the two by two texels beneath it
+void OcclusionMap::buildPyramid()
+{
+    for (std::size_t level = 1; level < levels_.size(); level++)
+    {
+        const auto& finer = levels_[level - 1];
+        auto& coarser = levels_[level];
+        glm::ivec2 fineSize = sizes_[level - 1], size = sizes_[level];
+
+        for (int y = 0; y < size.y; y++)
+        {
+            int y0 = 2 * y, y1 = std::min(2 * y + 1, fineSize.y - 1);
+            for (int x = 0; x < size.x; x++)
+            {
+                int x0 = 2 * x, x1 = std::min(2 * x + 1, fineSize.x - 1);
+                coarser[(std::size_t)(y * size.x + x)] = std::max(
+                    std::max(finer[(std::size_t)(y0 * fineSize.x + x0)],
+                             finer[(std::size_t)(y0 * fineSize.x + x1)]),
+                    std::max(finer[(std::size_t)(y1 * fineSize.x + x0)],
+                             finer[(std::size_t)(y1 * fineSize.x + x1)]));
+            }
+        }
+    }
+}
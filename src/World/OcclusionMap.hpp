@@ -0,0 +1,73 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+#ifndef OCCLUSION_MAP
+#define OCCLUSION_MAP
+
+/**
+    An OcclusionMap tells whether a box is hidden behind what is already on
+    screen. Between begin() and end(), the Scene draws its occluders into a
+    small depth-only framebuffer: the instances that were visible last frame,
+    at their current places. end() reads that depth back and reduces it into
+    a pyramid, each level holding the furthest depth of four texels of the
+    level below. isOccluded() projects a box onto the screen, picks the level
+    at which the box covers no more than a few texels, and reports whether
+    the box's nearest point is behind all of them. The box is widened by a
+    texel to make up for the low resolution, so an occluder that only covers
+    the center of a texel does not hide what peeks around it. The readback
+    waits for the small pass to finish, which is the price of the test.
+**/
+
+#include "glm/glm.hpp"
+#include <GL/glew.h>
+#include <vector>
+
+class OcclusionMap
+{
+    public:
+        OcclusionMap();
+        ~OcclusionMap();
+        void begin();
+        void end(const glm::mat4& viewProjection);
+        bool isOccluded(const glm::vec3& min, const glm::vec3& max) const;
+
+        static bool isSupported();
+
+    private:
+        void resize(int width, int height);
+        void buildPyramid();
+
+    private:
+        const int WIDTH = 256; //texels, the height follows the window's shape
+
+        GLuint framebuffer_, depthBuffer_;
+        int width_, height_;
+        GLint viewport_[4]; //the window's, restored by end()
+        glm::mat4 viewProjection_; //that the depth was drawn with
+        std::vector<std::vector<float>> levels_; //finest first
+        std::vector<glm::ivec2> sizes_; //of each level
+};
+
+#endif
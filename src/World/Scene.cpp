@@ -26,13 +26,17 @@
 #include "Scene.hpp"
 #include "Modeling/Shading/ShaderManager.hpp"
 #include "glm/gtc/type_ptr.hpp"
+#include "Modeling/GLStateCache.hpp"
 #include <algorithm>
+#include <cstddef>
 #include <chrono>
+#include <functional>
 #include <iostream>
 
 
 Scene::Scene(const std::shared_ptr<Camera>& camera) :
-    camera_(camera), ambientLightUpdated_(true)
+    camera_(camera), ambientLightUpdated_(true), lightsUpdated_(true),
+    sceneBlock_(0), lightBlock_(0)
 {
     setAmbientLight(glm::vec3(1));
 }
@@ -50,14 +54,72 @@ void Scene::addModel(const InstancedModelPtr& model)
 void Scene::addModel(const InstancedModelPtr& model, const ProgramPtr& program)
 {
     auto programHandle = program->getHandle();
-    glUseProgram(programHandle);
+    GLStateCache::getInstance().useProgram(programHandle);
 
     model->saveAs(programHandle);
     GLint ambLU = glGetUniformLocation(programHandle, "ambientLight");
     GLint viewU = glGetUniformLocation(programHandle, "viewMatrix");
     GLint projU = glGetUniformLocation(programHandle, "projMatrix");
 
-    renderables_.push_back(Renderable(model, program, ambLU, viewU, projU));
+    std::vector<Light::Locations> lightUs;
+    if (sceneBlock_)
+        bindUniformBlocks(programHandle);
+    else
+        for (std::size_t j = 0; j < lights_.size(); j++)
+            lightUs.push_back(lights_[j]->locate(programHandle, j));
+
+    renderables_.push_back(Renderable(model, program, ambLU, viewU, projU,
+                                      lightUs));
+    sortQueue();
+}
+
+
+
+//points the Program's uniform blocks at the buffers shared by all Programs
+void Scene::bindUniformBlocks(GLuint programHandle)
+{
+    GLuint sceneIndex = glGetUniformBlockIndex(programHandle, "SceneBlock");
+    if (sceneIndex != GL_INVALID_INDEX)
+        glUniformBlockBinding(programHandle, sceneIndex, SCENE_BLOCK_BINDING);
+
+    GLuint lightIndex = glGetUniformBlockIndex(programHandle, "LightBlock");
+    if (lightIndex != GL_INVALID_INDEX)
+        glUniformBlockBinding(programHandle, lightIndex, LIGHT_BLOCK_BINDING);
+}
+
+
+
+//orders the Renderables so that those sharing a Mesh, Program, or buffers
+//are drawn back to back, and the GLStateCache can skip rebinding them
+void Scene::sortQueue()
+{
+    queue_.resize(renderables_.size());
+    for (std::size_t j = 0; j < queue_.size(); j++)
+        queue_[j] = j;
+
+    std::stable_sort(queue_.begin(), queue_.end(),
+        [this](std::size_t a, std::size_t b)
+        {
+            const auto& x = renderables_[a];
+            const auto& y = renderables_[b];
+
+            auto xMesh = x.model->getMesh().get();
+            auto yMesh = y.model->getMesh().get();
+            if (xMesh != yMesh)
+                return std::less<Mesh*>()(xMesh, yMesh);
+
+            auto xHandle = x.program->getHandle();
+            auto yHandle = y.program->getHandle();
+            if (xHandle != yHandle)
+                return xHandle < yHandle;
+
+            auto xBuffers = x.model->getOptionalDataBuffers();
+            auto yBuffers = y.model->getOptionalDataBuffers();
+            return std::lexicographical_compare(
+                xBuffers.begin(), xBuffers.end(),
+                yBuffers.begin(), yBuffers.end(),
+                std::owner_less<std::shared_ptr<OptionalDataBuffer>>());
+        });
 }
 
 
@@ -86,18 +148,64 @@ void Scene::setAmbientLight(const glm::vec3& rgb)
 
 
 
+void Scene::setOcclusionMap(const std::shared_ptr<OcclusionMap>& map)
+{
+    occlusionMap_ = map;
+    InstancedModel::setOcclusionMap(map);
+}
+
+
+
+//must be called before any Models are added, since it changes their shaders
+void Scene::useUniformBuffers()
+{
+    glGenBuffers(1, &sceneBlock_);
+    glGenBuffers(1, &lightBlock_);
+
+    GLStateCache::getInstance().bindBuffer(GL_UNIFORM_BUFFER, sceneBlock_);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(SceneBlock), nullptr,
+        GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, SCENE_BLOCK_BINDING, sceneBlock_);
+
+    Light::setUniformBlock(true);
+}
+
+
+
+bool Scene::isUniformBufferSupported()
+{
+    return GLEW_ARB_uniform_buffer_object;
+}
+
+
+
 float Scene::render()
 {
     using namespace std::chrono;
     auto start = steady_clock::now();
 
     camera_->startSync();
-    for (auto renderable : renderables_)
+    startSyncingLighting();
+    if (sceneBlock_)
+        syncUniformBuffers();
+    if (occlusionMap_)
+        renderOccluders();
+
+    GLuint lastHandle = 0;
+    for (std::size_t index : queue_)
     {
+        const auto& renderable = renderables_[index];
         GLuint handle = renderable.program->getHandle();
-        glUseProgram(handle);
-        camera_->sync(renderable.viewUniform, renderable.projUniform);
-        syncLighting(handle, renderable.ambientLightUniform);
+        if (handle != lastHandle)
+        {   //uniforms are per-Program, so a shared one only needs them once
+            GLStateCache::getInstance().useProgram(handle);
+            if (!sceneBlock_)
+            {
+                camera_->sync(renderable.viewUniform, renderable.projUniform);
+                syncLighting(renderable);
+            }
+            lastHandle = handle;
+        }
 
         renderable.model->render(handle);
     }
@@ -110,6 +218,33 @@ float Scene::render()
 
 
 
+//draws what the occluders showed last frame into the OcclusionMap, for the
+//Models to test their instances against during the main pass
+void Scene::renderOccluders()
+{
+    occlusionMap_->begin();
+    InstancedModel::setOccluderPass(true);
+
+    for (std::size_t index : queue_)
+    {
+        const auto& renderable = renderables_[index];
+        if (!renderable.model->isOccluder())
+            continue;
+
+        GLuint handle = renderable.program->getHandle();
+        GLStateCache::getInstance().useProgram(handle);
+        if (!sceneBlock_)
+            camera_->sync(renderable.viewUniform, renderable.projUniform);
+        renderable.model->render(handle);
+    }
+
+    InstancedModel::setOccluderPass(false);
+    occlusionMap_->end(camera_->getProjectionMatrix() *
+        camera_->calculateViewMatrix());
+}
+
+
+
 std::shared_ptr<Camera> Scene::getCamera()
 {
     return camera_;
@@ -138,21 +273,97 @@ glm::vec3 Scene::getAmbientLight()
 
 
 
-void Scene::syncLighting(GLuint programHandle, GLint ambientLightUniform)
+void Scene::startSyncingLighting()
+{
+    for (const auto& light : lights_)
+        if (light->isUpdated())
+            lightsUpdated_ = true;
+}
+
+
+
+void Scene::syncLighting(const Renderable& renderable)
 {
     if (ambientLightUpdated_)
-        glUniform3fv(ambientLightUniform, 1, glm::value_ptr(ambientLight_));
+        glUniform3fv(renderable.ambientLightUniform, 1,
+            glm::value_ptr(ambientLight_));
 
-    //todo: Light::sync needs to be optimized like Camera::sync
-    for (std::size_t j = 0; j < lights_.size(); j++)
-        lights_[j]->sync(programHandle, j);
+    //Lights added after the Program was linked are not in its shaders
+    if (lightsUpdated_)
+        for (std::size_t j = 0; j < renderable.lightUniforms.size(); j++)
+            lights_[j]->sync(renderable.lightUniforms[j]);
+}
+
+
+
+//writes what changed since the last frame into the buffers all Programs read
+void Scene::syncUniformBuffers()
+{
+    auto& state = GLStateCache::getInstance();
+    state.bindBuffer(GL_UNIFORM_BUFFER, sceneBlock_);
+
+    camera_->syncBlock(offsetof(SceneBlock, viewMatrix),
+                       offsetof(SceneBlock, projMatrix));
+    if (ambientLightUpdated_)
+        glBufferSubData(GL_UNIFORM_BUFFER, offsetof(SceneBlock, ambientLight),
+            sizeof(glm::vec3), glm::value_ptr(ambientLight_));
+
+    if (lightsUpdated_ && !lights_.empty())
+    {
+        lightBlockData_.clear();
+        for (const auto& light : lights_)
+            lightBlockData_.push_back(light->getBlockData());
+
+        state.bindBuffer(GL_UNIFORM_BUFFER, lightBlock_);
+        glBufferData(GL_UNIFORM_BUFFER,
+            lightBlockData_.size() * sizeof(Light::BlockData),
+            lightBlockData_.data(), GL_DYNAMIC_DRAW);
+        glBindBufferBase(GL_UNIFORM_BUFFER, LIGHT_BLOCK_BINDING, lightBlock_);
+    }
 }
 
 
 
 void Scene::doneSyncingLighting()
 {
-    ambientLightUpdated_ = true;
+    for (const auto& light : lights_)
+        light->markSynced();
+
+    ambientLightUpdated_ = false;
+    lightsUpdated_ = false;
+}
+
+
+
+//extensions have to be enabled before anything else in the shader
+std::string Scene::getExtensionsGLSL()
+{
+    if (!sceneBlock_)
+        return "";
+
+    return R".(
+            #extension GL_ARB_uniform_buffer_object : require
+        ).";
+}
+
+
+
+//the Camera's matrices and the ambient light, shared by both shaders
+std::string Scene::getUniformsGLSL()
+{
+    if (!sceneBlock_)
+        return R".(
+            uniform mat4 viewMatrix, projMatrix; //Camera & projection matrices
+            uniform vec3 ambientLight;
+        ).";
+
+    return R".(
+            layout(std140) uniform SceneBlock //see Scene::syncUniformBuffers
+            {
+                mat4 viewMatrix, projMatrix; //Camera & projection matrices
+                vec3 ambientLight;
+            };
+        ).";
 }
 
 
@@ -160,14 +371,13 @@ void Scene::doneSyncingLighting()
 SnippetPtr Scene::getVertexShaderGLSL()
 {
     return std::make_shared<ShaderSnippet>(
-        R".(
+        getExtensionsGLSL() + R".(
             // ********* VERTEX SHADER ********* \\
 
             //Scene fields
             attribute vec3 vertex; //position of the vertex
-            uniform mat4 viewMatrix, projMatrix; //Camera & projection matrices
-            uniform mat4 modelMatrix; //transforms model into world space
-        ).",
+            attribute mat4 modelMatrix; //per instance, see InstancedModel
+        )." + getUniformsGLSL(),
         R".(
             //Scene methods
             vec4 projectVertex()
@@ -188,19 +398,15 @@ SnippetPtr Scene::getVertexShaderGLSL()
 SnippetPtr Scene::getFragmentShaderGLSL()
 {
     return std::make_shared<ShaderSnippet>(
-        R".(
+        getExtensionsGLSL() + R".(
             // ********* FRAGMENT SHADER ********* \\
 
             //Scene fields
-            uniform vec3 ambientLight;
-            uniform mat4 viewMatrix, projMatrix; //Camera view and projection matrices
-            uniform mat4 modelMatrix; //matrix transforming model mesh into world space
-
             struct Colors
             {
                 vec3 material, lightBlend;
             };
-        ).",
+        )." + getUniformsGLSL(),
         R".(
             //Scene methods
         ).",
@@ -38,16 +38,26 @@
     affect them all simultaneously. This adds a bit of complexity, but is a
     very significant optimization: it gave an 9x speedup when it was first
     implemented, but this depends on the mapping of course.
+    Renderables are drawn in queue order, sorted by Mesh, Program, and buffers
+    so that neighbouring draws can reuse the state bound by the one before.
+    Uniform locations are found once per Program, when it is added. Where
+    uniform buffers are supported, the Camera, ambient light, and Lights are
+    instead written once per frame, and only when they change, into buffers
+    that every Program reads through the SceneBlock and LightBlock.
+    With an OcclusionMap, each frame starts with a small depth-only pass of
+    the occluding Models, which the Models then cull their instances against.
 
 **/
 
 #include "Camera.hpp"
 #include "Light.hpp"
+#include "OcclusionMap.hpp"
 #include "Modeling/Shading/Program.hpp"
 #include "Modeling/InstancedModel.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 #include <unordered_map>
 #include <vector>
+#include <string>
 
 class Scene
 {
@@ -58,6 +68,8 @@ class Scene
         void addLight(const std::shared_ptr<Light>& light);
         void setCamera(const std::shared_ptr<Camera>& camera);
         void setAmbientLight(const glm::vec3& rgb);
+        void setOcclusionMap(const std::shared_ptr<OcclusionMap>& map);
+        void useUniformBuffers();
         float render();
 
         std::shared_ptr<Camera> getCamera();
@@ -68,28 +80,51 @@ class Scene
         virtual SnippetPtr getVertexShaderGLSL();
         virtual SnippetPtr getFragmentShaderGLSL();
 
+        static bool isUniformBufferSupported();
+
         struct Renderable
         {
-            Renderable(InstancedModelPtr m, ProgramPtr prog, GLint a, GLint v, GLint p) :
+            Renderable(InstancedModelPtr m, ProgramPtr prog, GLint a, GLint v, GLint p,
+                       const std::vector<Light::Locations>& l) :
                 model(m), program(prog), ambientLightUniform(a),
-                viewUniform(v), projUniform(p)
+                viewUniform(v), projUniform(p), lightUniforms(l)
             {}
 
             InstancedModelPtr model;
             ProgramPtr program;
             GLint ambientLightUniform, viewUniform, projUniform;
+            std::vector<Light::Locations> lightUniforms; //one per Light
         };
 
     private:
-        void syncLighting(GLuint programHandle, GLint ambientLightUniform);
+        struct SceneBlock //std140 layout of the GLSL SceneBlock
+        {
+            glm::mat4 viewMatrix, projMatrix;
+            glm::vec4 ambientLight;
+        };
+
+        void sortQueue();
+        void bindUniformBlocks(GLuint programHandle);
+        void renderOccluders();
+        void startSyncingLighting();
+        void syncLighting(const Renderable& renderable);
+        void syncUniformBuffers();
         void doneSyncingLighting();
+        std::string getExtensionsGLSL();
+        std::string getUniformsGLSL();
 
     private:
         std::vector<Renderable> renderables_;
+        std::vector<std::size_t> queue_; //indices into renderables_, sorted
         LightList lights_;
         std::shared_ptr<Camera> camera_;
+        std::shared_ptr<OcclusionMap> occlusionMap_; //optional
         glm::vec3 ambientLight_;
-        bool ambientLightUpdated_;
+        bool ambientLightUpdated_, lightsUpdated_;
+        GLuint sceneBlock_, lightBlock_; //if uniform buffers are used
+        std::vector<Light::BlockData> lightBlockData_; //reused each sync
+
+        const GLuint SCENE_BLOCK_BINDING = 0, LIGHT_BLOCK_BINDING = 1;
 };
 
 
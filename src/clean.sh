@@ -1,4 +1,6 @@
 #!/bin/sh
-rm -rf CMakeFiles/
+rm -rf CMakeFiles/ tests/CMakeFiles/
 rm -f CMakeCache.txt cmake_install.cmake Makefile install_manifest.txt FoldingAtomata
+rm -f CTestTestfile.cmake tests/CTestTestfile.cmake tests/cmake_install.cmake tests/Makefile
+rm -f tests/*Test tests/*Benchmark
 echo "Successfully cleaned the build directory."
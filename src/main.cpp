@@ -28,6 +28,8 @@
 #include "main.hpp"
 #include "Options.hpp"
 #include "Viewer/Viewer.hpp"
+#include <algorithm>
+#include <chrono>
 #include <thread>
 #include <sstream>
 
@@ -36,16 +38,23 @@ const int MAX_FPS = 50;
 
 void animateThread()
 {
-    const int ANIMATE_DELAY = Options::getInstance().getAnimationDelay();
+    const std::chrono::milliseconds ANIMATE_DELAY(
+        Options::getInstance().getAnimationDelay());
     try
     {
         while (!readyToUpdate_)
             std::this_thread::sleep_for(std::chrono::milliseconds(15));
 
+        //frames are scheduled on the monotonic clock, and the Playback clock
+        //decides what they show, so a slow frame is never made up for later
+        auto nextFrame = std::chrono::steady_clock::now();
         while (true)
         {
-            Viewer::getInstance().animate(ANIMATE_DELAY);
-            std::this_thread::sleep_for(std::chrono::milliseconds(ANIMATE_DELAY));
+            Viewer::getInstance().animate();
+
+            auto now = std::chrono::steady_clock::now();
+            nextFrame = std::max(nextFrame + ANIMATE_DELAY, now);
+            std::this_thread::sleep_until(nextFrame);
         }
     }
     catch (std::exception& e)
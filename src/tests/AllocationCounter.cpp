@@ -0,0 +1,112 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+#include "AllocationCounter.hpp"
+#include <cstdlib>
+#include <atomic>
+#include <new>
+
+static std::atomic<std::size_t> allocations_(0);
+
+
+AllocationCounter::AllocationCounter() :
+    start_(allocations_.load())
+{}
+
+
+
+std::size_t AllocationCounter::count() const
+{
+    return allocations_.load() - start_;
+}
+
+
+
+static void* allocate(std::size_t size)
+{
+    allocations_.fetch_add(1, std::memory_order_relaxed);
+    void* memory = std::malloc(size > 0 ? size : 1);
+    if (!memory)
+        throw std::bad_alloc();
+    return memory;
+}
+
+
+
+void* operator new(std::size_t size)
+{
+    return allocate(size);
+}
+
+
+
+void* operator new[](std::size_t size)
+{
+    return allocate(size);
+}
+
+
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    allocations_.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size > 0 ? size : 1);
+}
+
+
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    allocations_.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size > 0 ? size : 1);
+}
+
+
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+
+
+void operator delete[](void* memory) noexcept
+{
+    std::free(memory);
+}
+
+
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{
+    std::free(memory);
+}
+
+
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept
+{
+    std::free(memory);
+}
@@ -0,0 +1,51 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+#ifndef ALLOCATION_COUNTER
+#define ALLOCATION_COUNTER
+
+/**
+    The allocation tests replace the global operator new so that they can
+    count every heap allocation in the process. The count is a single relaxed
+    atomic increment, so allocations made by the ThreadPool's workers are
+    counted just like those of the calling thread. An AllocationCounter
+    remembers the count when it is created, and count() reports how many
+    allocations any thread has made since then. The tests use this to prove
+    that the animation stops allocating once it has warmed up.
+**/
+
+#include <cstddef>
+
+class AllocationCounter
+{
+    public:
+        AllocationCounter();
+        std::size_t count() const; //allocations by any thread since creation
+
+    private:
+        std::size_t start_;
+};
+
+#endif
@@ -0,0 +1,196 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+/**
+    Runs SlotAnimator, the CPU half of SlotViewer::animate, on a synthetic
+    chain of atoms split between two InstanceStores as if they were two
+    elements. Each frame interpolates the positions and builds the atom
+    matrices in ThreadPool chunks, blends the bonds from cached keyframes
+    while prefetching those ahead, publishes the InstanceStores, and
+    acquires them again as the renderer would. Playback runs forward and
+    then in reverse. After a warm-up, no frame may allocate on any thread.
+    The rendering half needs an OpenGL context, so it is not covered here.
+**/
+
+#include "AllocationCounter.hpp"
+#include "Viewer/SlotAnimator.hpp"
+#include "Viewer/Playback.hpp"
+#include <iostream>
+#include <cstdlib>
+#include <random>
+#include <thread>
+
+const std::size_t N_ATOMS = 5000;
+const int N_SNAPSHOTS = 4;
+const int WARMUP = 50, FRAMES = 400, REVERSE_AT = 250; //frames
+const double FRAME_TIME = 40; //milliseconds of playback
+const float ATOM_SCALE = 0.15f, BOND_SCALE = 0.07f;
+
+
+TrajectoryPtr makeTrajectory()
+{
+    std::vector<AtomPtr> atoms;
+    std::vector<Bond> bonds;
+    for (std::size_t j = 0; j < N_ATOMS; j++)
+    {
+        atoms.push_back(std::make_shared<Atom>("C", 6, 0, 0.7f, 12));
+        if (j > 0)
+            bonds.push_back(Bond(j - 1, j));
+    }
+
+    auto trajectory = std::make_shared<Trajectory>(
+        std::make_shared<Topology>(atoms, bonds));
+
+    std::mt19937 generator(12345);
+    std::normal_distribution<float> step(0, 1);
+    for (int k = 0; k < N_SNAPSHOTS; k++)
+    {
+        auto snapshot = std::make_shared<Snapshot>();
+        glm::vec3 position;
+        for (std::size_t j = 0; j < N_ATOMS; j++)
+        {
+            position += glm::vec3(step(generator), step(generator),
+                                  step(generator));
+            snapshot->addPosition(position);
+        }
+        trajectory->addSnapshot(snapshot);
+    }
+
+    return trajectory;
+}
+
+
+
+//makes sure the counter sees allocations that other threads make
+bool countsOtherThreads()
+{
+    static int* volatile escaped; //so the allocation cannot be optimized out
+    std::atomic<bool> start(false), done(false);
+    std::thread other([&]()
+    {
+        while (!start)
+            std::this_thread::yield();
+        escaped = new int(0);
+        delete escaped;
+        done = true;
+    });
+
+    AllocationCounter counter;
+    start = true;
+    while (!done)
+        std::this_thread::yield();
+    auto allocations = counter.count();
+
+    other.join();
+    return allocations == 1;
+}
+
+
+
+int main()
+{
+    if (!countsOtherThreads())
+    {
+        std::cerr << "FAILED: allocations on other threads are not counted."
+            << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    auto trajectory = makeTrajectory();
+    const auto& bonds = trajectory->getTopology()->getBonds();
+
+    std::vector<int> order;
+    for (int j = 0; j < N_SNAPSHOTS; j++)
+        order.push_back(j);
+    SlotAnimator animator(trajectory, order, glm::vec3(1, 2, 3), false);
+
+    InstanceStore atomStores[2], bondStore;
+    for (std::size_t j = 0; j < N_ATOMS; j++)
+    {
+        auto& store = atomStores[j % 2];
+        store.add(glm::mat4());
+        animator.addAtom(store, store.size() - 1, ATOM_SCALE);
+    }
+    for (std::size_t j = 0; j < bonds.size(); j++)
+        bondStore.add(glm::mat4());
+    animator.setBonds(bondStore, BOND_SCALE);
+
+    auto keyframes = std::make_shared<KeyframeCache>(trajectory,
+                                                     (std::size_t)1 << 26);
+    keyframes->precompute(order);
+    animator.setKeyframes(keyframes, 3);
+
+    //start inside the first segment, and play it forward and then back
+    double time = Playback::getInstance().SNAPSHOT_DURATION / 3;
+    std::size_t allocations = 0;
+    for (int frame = 0; frame < WARMUP + FRAMES; frame++)
+    {
+        AllocationCounter counter;
+
+        time += frame < REVERSE_AT ? FRAME_TIME : -FRAME_TIME;
+        if (!animator.animate(time))
+        {
+            std::cerr << "FAILED: nothing was animated." << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        //the renderer's half, up to where it would upload to the GPU
+        for (auto& store : atomStores)
+        {
+            store.acquire();
+            store.getUpdatedRanges();
+        }
+        bondStore.acquire();
+        bondStore.getUpdatedRanges();
+
+        if (frame >= WARMUP)
+            allocations += counter.count();
+    }
+
+    auto stalls = animator.takeKeyframeStalls();
+    if (stalls.first > 0)
+    {
+        std::cerr << "FAILED: " << stalls.first << " frames missed cached " <<
+            "keyframes." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (animator.takeInstanceCounts().first == 0)
+    {
+        std::cerr << "FAILED: no instance was updated." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (allocations > 0)
+    {
+        std::cerr << "FAILED: " << allocations << " heap allocations in " <<
+            FRAMES << " frames after the warm-up." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "No heap allocations in " << FRAMES << " frames after the " <<
+        "warm-up." << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,148 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+/**
+    Stresses InstanceStore with a writer thread that publishes frames as fast
+    as it can while the main thread acquires them. Each frame sets a
+    different subset of the instances, and each matrix records the frame
+    that last set it, so the reader can tell exactly what every instance of
+    the frame it acquired should hold. The reader also keeps a mirror that
+    only copies getUpdatedRanges(), the way InstancedModel uploads to the
+    GPU, and that mirror has to match every frame it acquires, even when it
+    skips frames. Build with -DTHREAD_SANITIZER=ON to check the memory
+    ordering as well.
+**/
+
+#include "Modeling/InstanceStore.hpp"
+#include <iostream>
+#include <cstdlib>
+#include <thread>
+
+const std::size_t N_INSTANCES = 1000;
+const int FRAMES = 5000;
+const int STRIDE = 5; //frame f sets instance j if (j * 7 + f) % STRIDE == 0
+
+static int failures = 0;
+
+
+void check(bool condition, const std::string& what, int frame)
+{
+    if (condition)
+        return;
+
+    failures++;
+    if (failures <= 10)
+        std::cerr << "FAILED: " << what << " in frame " << frame << std::endl;
+}
+
+
+
+//instance 0 is set by every frame, so it tells the reader which one it has
+bool isSetBy(std::size_t instance, int frame)
+{
+    return instance == 0 || (instance * 7 + (std::size_t)frame) % STRIDE == 0;
+}
+
+
+
+int lastFrameToSet(std::size_t instance, int frame)
+{
+    if (instance == 0)
+        return frame;
+    int latest = frame - (int)((instance * 7 + (std::size_t)frame) % STRIDE);
+    return latest > 0 ? latest : 0; //frame 0 is what add() put there
+}
+
+
+
+glm::mat4 makeMatrix(std::size_t instance, int frame)
+{
+    glm::mat4 matrix((float)frame);
+    matrix[3] = glm::vec4((float)instance, 0, 0, 1);
+    return matrix;
+}
+
+
+
+void write(InstanceStore& store)
+{
+    for (int frame = 1; frame <= FRAMES; frame++)
+    {
+        for (std::size_t j = 0; j < N_INSTANCES; j++)
+            if (isSetBy(j, frame))
+                store.set(j, makeMatrix(j, frame));
+        store.publish();
+    }
+}
+
+
+
+int main()
+{
+    InstanceStore store;
+    for (std::size_t j = 0; j < N_INSTANCES; j++)
+        store.add(makeMatrix(j, 0));
+
+    std::vector<glm::mat4> mirror(N_INSTANCES);
+    for (std::size_t j = 0; j < N_INSTANCES; j++)
+        mirror[j] = makeMatrix(j, 0);
+
+    std::thread writer(write, std::ref(store));
+
+    int lastFrame = 0, framesSeen = 0;
+    while (lastFrame < FRAMES)
+    {
+        const auto& matrices = store.acquire();
+        for (const auto& range : store.getUpdatedRanges())
+            for (auto j = range.begin; j < range.end; j++)
+                mirror[j] = matrices[j];
+
+        int frame = (int)matrices[0][0][0];
+        check(frame >= lastFrame, "acquired an older frame", frame);
+        if (frame != lastFrame)
+            framesSeen++;
+        lastFrame = frame;
+
+        for (std::size_t j = 0; j < N_INSTANCES; j++)
+        {
+            auto expected = makeMatrix(j, lastFrameToSet(j, frame));
+            check(matrices[j] == expected, "torn or stale instance", frame);
+            check(mirror[j] == expected, "updated ranges missed a change",
+                  frame);
+        }
+    }
+
+    writer.join();
+
+    if (failures > 0)
+    {
+        std::cerr << failures << " checks failed." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "All InstanceStore checks passed, the reader saw " <<
+        framesSeen << " of " << FRAMES << " frames." << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,122 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+/**
+    Times one frame's worth of atom and bond matrices, built one instance at
+    a time by composing glm::translate, glm::rotate, and glm::scale as
+    SlotViewer used to, and then by the batched InstanceTransforms kernels.
+    It is not run by ctest, since timings depend on the machine. Pass the
+    number of atoms to try a larger protein.
+**/
+
+#include "Viewer/InstanceTransforms.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <chrono>
+#include <random>
+
+const float WIDTH = 0.07f;
+const float PI = 3.141592653589f;
+const int FRAMES = 200;
+
+
+glm::mat4 composeBondMatrix(const glm::vec3& start, const glm::vec3& end)
+{
+    glm::vec3 axis = end - start;
+    float length = glm::length(axis);
+    glm::vec3 z(0, 0, 1);
+    float angle = std::acos(glm::dot(z, axis) / length) * 180 / PI;
+
+    glm::mat4 matrix = glm::translate(glm::mat4(), start);
+    matrix = glm::rotate(matrix, angle, glm::cross(z, axis));
+    return glm::scale(matrix, glm::vec3(WIDTH, WIDTH, length));
+}
+
+
+
+template <typename Frame>
+double millisecondsPerFrame(const Frame& frame)
+{
+    using namespace std::chrono;
+    auto start = steady_clock::now();
+    for (int j = 0; j < FRAMES; j++)
+        frame();
+    auto diff = duration_cast<microseconds>(steady_clock::now() - start).count();
+    return diff / 1000.0 / FRAMES;
+}
+
+
+
+int main(int argc, char** argv)
+{
+    std::size_t nAtoms = 20000;
+    if (argc > 1)
+        nAtoms = (std::size_t)std::atol(argv[1]);
+
+    std::mt19937 generator(12345);
+    std::uniform_real_distribution<float> coordinate(-40, 40);
+    std::vector<glm::vec3> positions;
+    std::vector<float> scales;
+    std::vector<Bond> bonds;
+    for (std::size_t j = 0; j < nAtoms; j++)
+    {
+        positions.push_back(glm::vec3(coordinate(generator),
+            coordinate(generator), coordinate(generator)));
+        scales.push_back(0.15f * (1 + j % 3));
+        if (j > 0)
+            bonds.push_back(Bond(j - 1, j));
+    }
+
+    std::vector<glm::mat4> atomMatrices(nAtoms), bondMatrices(bonds.size());
+
+    double composed = millisecondsPerFrame([&]()
+    {
+        for (std::size_t j = 0; j < nAtoms; j++)
+            atomMatrices[j] = glm::scale(glm::translate(glm::mat4(),
+                positions[j]), glm::vec3(scales[j]));
+        for (std::size_t j = 0; j < bonds.size(); j++)
+            bondMatrices[j] = composeBondMatrix(positions[bonds[j].first],
+                                                positions[bonds[j].second]);
+    });
+
+    double batched = millisecondsPerFrame([&]()
+    {
+        InstanceTransforms::generateAtomMatrices(positions.data(),
+            scales.data(), atomMatrices.data(), nAtoms);
+        InstanceTransforms::generateBondMatrices(positions.data(),
+            bonds.data(), WIDTH, bondMatrices.data(), bonds.size());
+    });
+
+    std::cout << std::fixed << std::setprecision(3) << nAtoms <<
+        " atoms and " << bonds.size() << " bonds, per frame:" << std::endl;
+    std::cout << "    composed per instance: " << composed << " ms" << std::endl;
+    std::cout << "    batched kernels:       " << batched << " ms (" <<
+        std::setprecision(1) << composed / batched << "x)" << std::endl;
+
+    //keeps the optimizer from discarding the matrices
+    return atomMatrices[1][3][0] + bondMatrices[1][3][0] > 1e9f ? 1 : 0;
+}
@@ -0,0 +1,325 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+/**
+    Checks the batched kernels of InstanceTransforms against the
+    single-instance versions, which are the scalar path, and checks the bond
+    matrices against the glm::translate, glm::rotate, and glm::scale
+    composition they replaced. The bonds include the cases the branchless
+    Duff basis has to get right: axes along +z and -z, axes just either side
+    of the xy plane, and atoms that coincide. Batches start and end off the
+    four-wide boundaries, so the remainders go through the scalar path too.
+**/
+
+#include "Viewer/InstanceTransforms.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include <algorithm>
+#include <iostream>
+#include <cfloat>
+#include <cmath>
+#include <random>
+
+const float WIDTH = 0.07f;
+const float TOLERANCE = 1e-5f; //relative to the size of the values compared
+const float COMPOSED_TOLERANCE = 1e-4f; //acos is imprecise near the poles
+const float PI = 3.141592653589f;
+
+static int failures = 0;
+
+
+void check(bool condition, const std::string& what, std::size_t index)
+{
+    if (condition)
+        return;
+
+    failures++;
+    if (failures <= 10)
+        std::cerr << "FAILED: " << what << " at " << index << std::endl;
+}
+
+
+
+float difference(const glm::mat4& a, const glm::mat4& b)
+{
+    float largest = 0;
+    for (int c = 0; c < 4; c++)
+        for (int r = 0; r < 4; r++)
+            largest = std::max(largest, std::fabs(a[c][r] - b[c][r]));
+    return largest;
+}
+
+
+
+float magnitude(const glm::mat4& matrix)
+{
+    float largest = 1;
+    for (int c = 0; c < 4; c++)
+        for (int r = 0; r < 4; r++)
+            largest = std::max(largest, std::fabs(matrix[c][r]));
+    return largest;
+}
+
+
+
+//how bonds were placed before the batch kernels, see SlotViewer's history
+glm::mat4 composeBondMatrix(const glm::vec3& start, const glm::vec3& end)
+{
+    glm::vec3 axis = end - start;
+    float length = glm::length(axis);
+    glm::mat4 matrix = glm::translate(glm::mat4(), start);
+
+    glm::vec3 z(0, 0, 1);
+    glm::vec3 rotationAxis = glm::cross(z, axis);
+    if (glm::length(rotationAxis) > FLT_EPSILON * length)
+    {
+        float angle = std::acos(glm::dot(z, axis) / length) * 180 / PI;
+        matrix = glm::rotate(matrix, angle, rotationAxis);
+    }
+    else if (axis.z < 0)
+        matrix = glm::scale(matrix, glm::vec3(1, -1, -1)); //half turn about x
+
+    return glm::scale(matrix, glm::vec3(WIDTH, WIDTH, length));
+}
+
+
+
+std::vector<glm::vec3> makePositions(std::size_t count)
+{
+    std::mt19937 generator(12345);
+    std::uniform_real_distribution<float> coordinate(-40, 40);
+
+    std::vector<glm::vec3> positions;
+    for (std::size_t j = 0; j < count; j++)
+        positions.push_back(glm::vec3(coordinate(generator),
+            coordinate(generator), coordinate(generator)));
+
+    //axes for the bonds that start at 0: +z, -z, near +0 and -0 z, none
+    positions[1] = positions[0] + glm::vec3(0, 0, 1.5f);
+    positions[2] = positions[0] + glm::vec3(0, 0, -1.5f);
+    positions[3] = positions[0] + glm::vec3(1.2f, 0.3f, 1e-7f);
+    positions[4] = positions[0] + glm::vec3(1.2f, 0.3f, -1e-7f);
+    positions[5] = positions[0];
+    positions[6] = positions[0] + glm::vec3(0, 1e-3f, -1.5f);
+    return positions;
+}
+
+
+
+std::vector<Bond> makeBonds(std::size_t nAtoms)
+{
+    std::vector<Bond> bonds;
+    for (std::size_t j = 1; j <= 6; j++)
+        bonds.push_back(Bond(0, j));
+    for (std::size_t j = 7; j + 1 < nAtoms; j++)
+        bonds.push_back(Bond(j, j + 1));
+    return bonds;
+}
+
+
+
+//the KeyframeCache's layout: start x, y, z then axis x, y, z, in lanes of 4
+std::vector<float> makeBlocks(const std::vector<glm::vec3>& positions,
+                              const std::vector<Bond>& bonds)
+{
+    const auto SIZE = InstanceTransforms::BOND_BLOCK_SIZE;
+    std::vector<float> blocks((bonds.size() + 3) / 4 * SIZE, 0);
+    for (std::size_t j = 0; j < bonds.size(); j++)
+    {
+        auto start = positions[bonds[j].first];
+        auto axis = positions[bonds[j].second] - start;
+        float* block = &blocks[j / 4 * SIZE + j % 4];
+        for (int k = 0; k < 3; k++)
+        {
+            block[k * 4] = start[k];
+            block[(k + 3) * 4] = axis[k];
+        }
+    }
+    return blocks;
+}
+
+
+
+void testInterpolation(const std::vector<glm::vec3>& a,
+                       const std::vector<glm::vec3>& b)
+{
+    const float BLEND = 0.37f;
+    const glm::vec3 OFFSET(1, -2, 3);
+    std::vector<glm::vec3> positions(a.size());
+
+    //an odd start and count, so both ends fall off the SSE boundary
+    std::size_t first = 1, count = a.size() - 2;
+    InstanceTransforms::interpolate(&a[first], &b[first], BLEND, OFFSET,
+                                    &positions[first], count);
+
+    for (std::size_t j = first; j < first + count; j++)
+    {
+        auto expected = a[j] + (b[j] - a[j]) * BLEND + OFFSET;
+        float error = glm::length(positions[j] - expected);
+        check(error <= TOLERANCE * (glm::length(expected) + 1),
+              "interpolate", j);
+    }
+}
+
+
+
+void testAtoms(const std::vector<glm::vec3>& positions)
+{
+    std::vector<float> scales;
+    for (std::size_t j = 0; j < positions.size(); j++)
+        scales.push_back(0.15f * (1 + j % 3));
+
+    std::vector<glm::mat4> matrices(positions.size());
+    InstanceTransforms::generateAtomMatrices(positions.data(), scales.data(),
+                                             matrices.data(), positions.size());
+
+    for (std::size_t j = 0; j < positions.size(); j++)
+    {
+        auto scalar = InstanceTransforms::atomMatrix(positions[j], scales[j]);
+        auto composed = glm::scale(glm::translate(glm::mat4(), positions[j]),
+                                   glm::vec3(scales[j]));
+        check(difference(matrices[j], scalar) <= TOLERANCE * magnitude(scalar),
+              "atom vs scalar", j);
+        check(difference(matrices[j], composed) <=
+              TOLERANCE * magnitude(composed), "atom vs composed", j);
+    }
+}
+
+
+
+void checkBondMatrix(const glm::mat4& matrix, const glm::vec3& start,
+                     const glm::vec3& end, std::size_t index)
+{
+    float scale = glm::length(start) + 1;
+
+    //the unit bond's ends land on the atoms
+    auto base = glm::vec3(matrix * glm::vec4(0, 0, 0, 1));
+    auto tip = glm::vec3(matrix * glm::vec4(0, 0, 1, 1));
+    check(glm::length(base - start) <= TOLERANCE * scale, "bond start", index);
+    check(glm::length(tip - end) <= TOLERANCE * scale, "bond end", index);
+
+    //the cross-section is a right-handed orthonormal frame around the axis
+    auto u = glm::vec3(matrix[0]) / WIDTH;
+    auto v = glm::vec3(matrix[1]) / WIDTH;
+    auto w = glm::vec3(matrix[2]);
+    float length = glm::length(w);
+    w = length > 0 ? w / length : glm::vec3(0, 0, 1);
+
+    check(std::fabs(glm::length(u) - 1) <= TOLERANCE, "u is unit", index);
+    check(std::fabs(glm::length(v) - 1) <= TOLERANCE, "v is unit", index);
+    check(std::fabs(glm::dot(u, v)) <= TOLERANCE, "u is normal to v", index);
+    check(std::fabs(glm::dot(u, w)) <= TOLERANCE, "u is normal to w", index);
+    check(std::fabs(glm::dot(v, w)) <= TOLERANCE, "v is normal to w", index);
+    check(glm::length(glm::cross(u, v) - w) <= TOLERANCE, "handedness", index);
+
+    //the bond mesh is round, so only the axis has to match the old matrices
+    if (glm::length(end - start) > FLT_EPSILON)
+    {
+        auto composed = composeBondMatrix(start, end);
+        auto composedTip = glm::vec3(composed * glm::vec4(0, 0, 1, 1));
+        float reach = scale + glm::length(end - start);
+        check(glm::length(composedTip - tip) <= COMPOSED_TOLERANCE * reach,
+              "bond vs composed", index);
+    }
+}
+
+
+
+void testBonds(const std::vector<glm::vec3>& positions,
+               const std::vector<Bond>& bonds)
+{
+    std::vector<glm::mat4> matrices(bonds.size());
+    InstanceTransforms::generateBondMatrices(positions.data(), bonds.data(),
+                                             WIDTH, matrices.data(), bonds.size());
+
+    for (std::size_t j = 0; j < bonds.size(); j++)
+    {
+        auto start = positions[bonds[j].first];
+        auto end = positions[bonds[j].second];
+        auto scalar = InstanceTransforms::bondMatrix(start, end, WIDTH);
+        check(difference(matrices[j], scalar) <= TOLERANCE * magnitude(scalar),
+              "bond vs scalar", j);
+        checkBondMatrix(matrices[j], start, end, j);
+    }
+}
+
+
+
+void testBlendedBonds(const std::vector<glm::vec3>& a,
+                      const std::vector<glm::vec3>& b,
+                      const std::vector<Bond>& bonds)
+{
+    const float BLEND = 0.6f;
+    const glm::vec3 OFFSET(-3, 2, 1);
+    auto blocksA = makeBlocks(a, bonds);
+    auto blocksB = makeBlocks(b, bonds);
+
+    //ThreadPool chunks need not start on a block, so neither does this
+    std::size_t first = 3, count = bonds.size() - 5;
+    std::vector<glm::mat4> matrices(count);
+    InstanceTransforms::blendBondMatrices(blocksA.data(), blocksB.data(),
+        first, BLEND, OFFSET, WIDTH, matrices.data(), count);
+
+    for (std::size_t j = first; j < first + count; j++)
+    {
+        auto scalar = InstanceTransforms::blendBondMatrix(blocksA.data(),
+            blocksB.data(), j, BLEND, OFFSET, WIDTH);
+        auto& matrix = matrices[j - first];
+        check(difference(matrix, scalar) <= TOLERANCE * magnitude(scalar),
+              "blended bond vs scalar", j);
+
+        auto startA = a[bonds[j].first], startB = b[bonds[j].first];
+        auto axisA = a[bonds[j].second] - startA;
+        auto axisB = b[bonds[j].second] - startB;
+        auto start = startA + (startB - startA) * BLEND + OFFSET;
+        auto axis = axisA + (axisB - axisA) * BLEND;
+        checkBondMatrix(matrix, start, start + axis, j);
+    }
+}
+
+
+
+int main()
+{
+    const std::size_t N_ATOMS = 4099;
+    auto positionsA = makePositions(N_ATOMS);
+    auto positionsB = positionsA;
+    for (std::size_t j = 7; j < N_ATOMS; j++) //keep the special axes in both
+        positionsB[j] += glm::vec3(0.5f, -0.25f, 0.125f) * (float)(j % 5);
+    auto bonds = makeBonds(N_ATOMS);
+
+    testInterpolation(positionsA, positionsB);
+    testAtoms(positionsA);
+    testBonds(positionsA, bonds);
+    testBlendedBonds(positionsA, positionsB, bonds);
+
+    if (failures > 0)
+    {
+        std::cerr << failures << " checks failed." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "All InstanceTransforms checks passed." << std::endl;
+    return EXIT_SUCCESS;
+}
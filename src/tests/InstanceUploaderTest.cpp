@@ -0,0 +1,193 @@
+
+/******************************************************************************\
+                     This file is part of Folding Atomata,
+          a program that displays 3D views of Folding@home proteins.
+
+                      Copyright (c) 2013, Jesse Victors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see http://www.gnu.org/licenses/
+
+                For information regarding this software email:
+                                Jesse Victors
+                         jvictors@jessevictors.com
+\******************************************************************************/
+
+/**
+    Plays frames through an InstanceStore and an InstanceUploader the way
+    InstancedModel draws them, into a vector that stands in for the matrix
+    buffer. Each frame is drawn by an occluder pass and then the main pass,
+    and each pass sees every instance, some of them, or none after culling.
+    Whenever a pass draws, the buffer has to hold exactly what it draws. Two
+    unculled frames in a row must only send the ranges that changed.
+**/
+
+#include "Modeling/InstanceUploader.hpp"
+#include <iostream>
+#include <cstdlib>
+#include <string>
+
+const std::size_t N_INSTANCES = 200;
+const int FRAMES = 2000;
+
+enum class Culling
+{
+    NONE, SOME, ALL
+};
+
+static int failures = 0;
+
+
+void check(bool condition, const std::string& what, int frame)
+{
+    if (condition)
+        return;
+
+    failures++;
+    if (failures <= 10)
+        std::cerr << "FAILED: " << what << " in frame " << frame << std::endl;
+}
+
+
+
+glm::mat4 makeMatrix(std::size_t instance, int frame)
+{
+    glm::mat4 matrix((float)frame);
+    matrix[3] = glm::vec4((float)instance, 0, 0, 1);
+    return matrix;
+}
+
+
+
+class Drawer
+{
+    public:
+        Drawer(InstanceStore& store);
+        void draw(Culling culling, int frame);
+        std::size_t takeWholeUploads();
+
+    private:
+        InstanceStore& store_;
+        InstanceUploader uploader_;
+        std::vector<glm::mat4> buffer_, visible_;
+        std::size_t wholeUploads_;
+};
+
+
+
+Drawer::Drawer(InstanceStore& store) :
+    store_(store), wholeUploads_(0)
+{}
+
+
+
+//one pass of InstancedModel::render, for a model that is culled
+void Drawer::draw(Culling culling, int frame)
+{
+    const auto& matrices = store_.acquire();
+    auto sendAll = [&](const std::vector<glm::mat4>& all)
+    {
+        buffer_ = all;
+        wholeUploads_++;
+    };
+
+    if (culling == Culling::NONE)
+    {
+        uploader_.uploadAll(matrices, store_.getUpdatedRanges(), sendAll,
+            [&](const InstanceStore::Range& range)
+            {
+                for (auto j = range.begin; j < range.end; j++)
+                    buffer_[j] = matrices[j];
+            }
+        );
+        check(buffer_ == matrices, "stale matrices drawn", frame);
+        return;
+    }
+
+    visible_.clear();
+    if (culling == Culling::SOME)
+        for (auto j = (std::size_t)frame % 3; j < matrices.size(); j += 3)
+            visible_.push_back(matrices[j]);
+
+    bool drawn = uploader_.uploadVisible(visible_, sendAll);
+    check(drawn == !visible_.empty(), "wrong visibility", frame);
+    if (drawn)
+        check(buffer_ == visible_, "wrong visible matrices", frame);
+}
+
+
+
+std::size_t Drawer::takeWholeUploads()
+{
+    auto count = wholeUploads_;
+    wholeUploads_ = 0;
+    return count;
+}
+
+
+
+//frame f moves every instance j with (j + f) % 7 == 0
+void advance(InstanceStore& store, int frame)
+{
+    for (std::size_t j = 0; j < N_INSTANCES; j++)
+        if ((j + (std::size_t)frame) % 7 == 0)
+            store.set(j, makeMatrix(j, frame));
+    store.publish();
+}
+
+
+
+int main()
+{
+    InstanceStore store;
+    for (std::size_t j = 0; j < N_INSTANCES; j++)
+        store.add(makeMatrix(j, 0));
+
+    Drawer drawer(store);
+    drawer.draw(Culling::NONE, 0);
+    drawer.takeWholeUploads();
+
+    //the occluder pass consumes a frame in which everything is culled, and
+    //the main pass then sees the whole model with no new ranges of its own
+    advance(store, 1);
+    drawer.draw(Culling::ALL, 1);
+    drawer.draw(Culling::NONE, 1);
+    check(drawer.takeWholeUploads() == 1, "not sent whole after culling", 1);
+
+    advance(store, 2);
+    drawer.draw(Culling::NONE, 2);
+    drawer.draw(Culling::NONE, 2);
+    check(drawer.takeWholeUploads() == 0, "sent whole without need", 2);
+
+    //every combination of culling in the two passes, in a fixed order
+    const Culling CULLINGS[] = { Culling::NONE, Culling::SOME, Culling::ALL };
+    unsigned int seed = 12345;
+    for (int frame = 3; frame < FRAMES; frame++)
+    {
+        advance(store, frame);
+        for (int pass = 0; pass < 2; pass++)
+        {
+            seed = seed * 1103515245 + 12345;
+            drawer.draw(CULLINGS[(seed >> 16) % 3], frame);
+        }
+    }
+
+    if (failures > 0)
+    {
+        std::cerr << failures << " checks failed." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "All InstanceUploader checks passed." << std::endl;
+    return EXIT_SUCCESS;
+}